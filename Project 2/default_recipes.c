@@ -0,0 +1,95 @@
+/* generated by recipe_asm from recipes.txt, do not edit */
+
+#include "timeline.h"
+
+// the image, its decoded stream and its timelines are used where they
+// are, keep them in flash with the other constants so none of it takes RAM
+#ifndef RECIPE_HOST
+#pragma push
+#pragma CONST_SEG ROM_VAR
+#endif
+
+const UINT8 default_recipe_image[] =
+{
+  /* header */
+  0x52, 0x43, 0x50, 0x49, 0x01, 0x09, 0x00, 0x2F, 0x09, 0x14, 0x00, 0x00, 0x00, 0x04, 0x00, 0x0B, 0x00, 0x0F, 0x00, 0x16, 0x00, 0x22, 0x00, 0x25, 0x00, 0x29, 0x00, 0x2C,
+  /* 0 default_delay */
+  0x20, 0x25, 0x20, 0x00,
+  /* 1 default_loop */
+  0x23, 0x80, 0x21, 0x24, 0xA0, 0x20, 0x00,
+  /* 2 wait_zero */
+  0x22, 0x40, 0x23, 0x00,
+  /* 3 long_delay */
+  0x22, 0x23, 0x5F, 0x5F, 0x5F, 0x24, 0x00,
+  /* 4 every_position */
+  0x20, 0x4A, 0x21, 0x4A, 0x22, 0x4A, 0x23, 0x4A, 0x24, 0x4A, 0x25, 0x00,
+  /* 5 immediate_end */
+  0x00, 0x23, 0x00,
+  /* 6 command_error */
+  0x20, 0x25, 0x26, 0x00,
+  /* 7 nested_loop */
+  0x81, 0x81, 0x00,
+  /* 8 load_opcode */
+  0x25, 0x42, 0xC4,
+};
+
+const UINT16 default_recipe_image_length = 75;
+
+#ifndef RECIPE_SWITCH_DISPATCH
+const struct Instruction default_recipe_image_stream[] =
+{
+  /* 0 default_delay */
+  {1, 0}, {1, 5}, {1, 0}, {0, 0},
+  /* 1 default_loop */
+  {1, 3}, {4, 0}, {1, 1}, {1, 4}, {5, 0}, {1, 0}, {0, 0},
+  /* 2 wait_zero */
+  {1, 2}, {2, 0}, {1, 3}, {0, 0},
+  /* 3 long_delay */
+  {1, 2}, {1, 3}, {2, 31}, {2, 31}, {2, 31}, {1, 4}, {0, 0},
+  /* 4 every_position */
+  {1, 0}, {2, 10}, {1, 1}, {2, 10}, {1, 2}, {2, 10}, {1, 3}, {2, 10}, {1, 4}, {2, 10}, {1, 5}, {0, 0},
+  /* 5 immediate_end */
+  {0, 0}, {1, 3}, {0, 0},
+  /* 6 command_error */
+  {1, 0}, {1, 5}, {1, 6}, {0, 0},
+  /* 7 nested_loop */
+  {4, 1}, {4, 1}, {0, 0},
+  /* 8 load_opcode */
+  {1, 5}, {2, 2}, {6, 4},
+};
+
+const UINT16 default_recipe_image_stream_length = 47;
+#endif
+
+#ifdef RECIPE_PLAYBACK
+const struct TimelineEvent default_recipe_image_timeline_events[] =
+{
+  /* 0 default_delay */
+  {0, 0x00}, {1, 0x05}, {2, 0x00}, {3, 0xFF},
+  /* 1 default_loop */
+  {0, 0x03}, {2, 0x01}, {3, 0x04}, {5, 0x00}, {6, 0xFF},
+  /* 2 wait_zero */
+  {0, 0x02}, {2, 0x03}, {3, 0xFF},
+  /* 3 long_delay */
+  {0, 0x02}, {1, 0x03}, {98, 0x04}, {99, 0xFF},
+  /* 4 every_position */
+  {0, 0x00}, {12, 0x01}, {24, 0x02}, {36, 0x03}, {48, 0x04}, {60, 0x05}, {61, 0xFF},
+  /* 5 immediate_end */
+  {0, 0xFF},
+  /* 6 command_error, none */
+  /* 7 nested_loop, none */
+  /* 8 load_opcode */
+  {0, 0x05}, {4, 0x84}, {5, 0x00}, {17, 0x01}, {29, 0x02}, {41, 0x03}, {53, 0x04}, {65, 0x05}, {66, 0xFF},
+};
+
+const UINT16 default_recipe_image_timeline_start[] =
+{
+  0, 4, 9, 12, 16, 23, 24, 24, 24, 33,
+};
+
+const UINT8 default_recipe_image_timeline_recipes = 9;
+#endif
+
+#ifndef RECIPE_HOST
+#pragma pop
+#endif
@@ -0,0 +1,205 @@
+#include "interpreter.h"
+
+#ifndef RECIPE_SWITCH_DISPATCH
+const struct Instruction *recipe_stream;
+#endif
+
+
+/*
+ * Header: puts a cursor at the start of a recipe
+ *
+ * Params: cursor, recipe number
+ * Return: void
+ */
+void StartRecipe(struct RecipeCursor *cursor, UINT8 number)
+{
+  cursor->recipe_number = number;
+  cursor->PC = RecipeStart(number);
+  cursor->WC = 0;
+  cursor->LPC = 0;
+}
+
+// One handler per command. Recipes are verified when they are loaded, so
+// none of them checks anything.
+
+static enum RECIPE_STEP run_end(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  (void)cursor;
+  (void)parameter;
+  (void)position;
+  return RECIPE_STEP_END;
+}
+
+static enum RECIPE_STEP run_mov(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  *position = parameter;
+  cursor->PC++;
+  return RECIPE_STEP_MOVE;
+}
+
+static enum RECIPE_STEP run_wait(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  (void)position;
+  if(0 == cursor->WC)
+  {
+    // WAIT n takes n + 1 ticks, WAIT 0 just the one
+    cursor->WC = parameter;
+    if(0 == parameter)
+    {
+      cursor->PC++;
+    }
+  }
+  else
+  {
+    cursor->WC--;
+    if(0 == cursor->WC)
+    {
+      cursor->PC++;
+    }
+  }
+  return RECIPE_STEP_NONE;
+}
+
+static enum RECIPE_STEP run_start_loop(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  (void)position;
+  cursor->LPC = parameter;
+  cursor->LPS = cursor->PC + 1;
+  cursor->PC++;
+  return RECIPE_STEP_NONE;
+}
+
+static enum RECIPE_STEP run_end_loop(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  (void)parameter;
+  (void)position;
+  if(0 == cursor->LPC)
+  {
+    cursor->PC++;
+  }
+  else
+  {
+    cursor->LPC--;
+    cursor->PC = cursor->LPS;
+  }
+  return RECIPE_STEP_NONE;
+}
+
+static enum RECIPE_STEP run_load(struct RecipeCursor *cursor, UINT8 parameter, UINT8 *position)
+{
+  (void)position;
+  cursor->recipe_number = parameter;
+  cursor->PC = RecipeStart(parameter);
+  return RECIPE_STEP_NONE;
+}
+
+/*
+ * Header: runs the next command, decoding it with a switch. Portable
+ *         fallback of RunRecipeThreaded, needs no RAM for a decoded stream.
+ *
+ * Params: cursor of the running recipe, position to move to
+ * Return: what the stepper has to do
+ */
+enum RECIPE_STEP RunRecipeSwitch(struct RecipeCursor *cursor, UINT8 *position)
+{
+  UINT8 command = recipe_code[cursor->PC];
+  UINT8 parameter = command & PARAMETER_MASK;
+
+  switch(command & OPCODE_MASK)
+  {
+    case MOV:
+      return run_mov(cursor, parameter, position);
+
+    case WAIT:
+      return run_wait(cursor, parameter, position);
+
+    case START_LOOP:
+      return run_start_loop(cursor, parameter, position);
+
+    case END_LOOP:
+      return run_end_loop(cursor, parameter, position);
+
+    case LOAD:
+      return run_load(cursor, parameter, position);
+  }
+  return run_end(cursor, parameter, position);
+}
+
+#ifndef RECIPE_SWITCH_DISPATCH
+
+// indexed by opcode >> 5, the opcodes that do not exist never pass the
+// verifier and only fill the gaps
+static enum RECIPE_STEP (*const handlers[RECIPE_HANDLERS])(struct RecipeCursor *, UINT8, UINT8 *) =
+{
+  run_end,          // END
+  run_mov,          // MOV
+  run_wait,         // WAIT
+  run_end,
+  run_start_loop,   // START_LOOP
+  run_end_loop,     // END_LOOP
+  run_load,         // LOAD
+  run_end
+};
+
+/*
+ * Header: Decodes the loaded image and runs it from the decoded stream.
+ *         Every command, rejected recipes included, is decoded at the
+ *         offset it has in recipe_code so PCs mean the same in both.
+ *
+ * Params: room for recipe_code_length instructions, it has to stay there
+ *         while the recipes run
+ * Return: void
+ */
+void DecodeRecipes(struct Instruction *stream)
+{
+  UINT16 pc;
+
+  for(pc = 0; pc < recipe_code_length; pc++)
+  {
+    stream[pc].handler = recipe_code[pc] >> 5;
+    stream[pc].parameter = recipe_code[pc] & PARAMETER_MASK;
+  }
+  recipe_stream = stream;
+}
+
+/*
+ * Header: Runs the loaded image from a stream decoded ahead of time, such
+ *         as the one recipe_asm generates in flash. The stream is checked
+ *         against the image so a stale one is never run.
+ *
+ * Params: stream and its length in instructions
+ * Return: 0 if it is the stream of the loaded image, 1 if not
+ */
+UINT8 UseRecipeStream(const struct Instruction *stream, UINT16 length)
+{
+  UINT16 pc;
+
+  if(recipe_code_length != length)
+  {
+    return 1;
+  }
+  for(pc = 0; pc < length; pc++)
+  {
+    if(recipe_code[pc] >> 5 != stream[pc].handler || (recipe_code[pc] & PARAMETER_MASK) != stream[pc].parameter)
+    {
+      return 1;
+    }
+  }
+  recipe_stream = stream;
+  return 0;
+}
+
+/*
+ * Header: runs the next command straight from the decoded stream through
+ *         the handler table, nothing is decoded while the recipe runs
+ *
+ * Params: cursor of the running recipe, position to move to
+ * Return: what the stepper has to do
+ */
+enum RECIPE_STEP RunRecipeThreaded(struct RecipeCursor *cursor, UINT8 *position)
+{
+  const struct Instruction *instruction = &recipe_stream[cursor->PC];
+  return handlers[instruction->handler](cursor, instruction->parameter, position);
+}
+
+#endif
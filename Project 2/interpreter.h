@@ -0,0 +1,73 @@
+#ifndef _interpreter_
+#define _interpreter_
+
+#include "recipe.h"
+
+// The recipe interpreter, apart from the steppers so the host benchmark
+// (recipe_bench.c) runs the same code as the firmware. Each call runs one
+// command, one tick, of a recipe that passed VerifyRecipes, and tells the
+// stepper what to do about it.
+
+// Where a recipe is while it runs, every stepper has one. PC and LPS are
+// offsets into recipe_code and recipe_stream alike.
+struct RecipeCursor
+{
+  UINT8 recipe_number;
+
+  // Program counter
+  UINT16 PC;
+
+  // Wait counter
+  UINT8 WC;
+
+  // Loop start position
+  UINT16 LPS;
+
+  // Loop counter
+  UINT8 LPC;
+};
+
+enum RECIPE_STEP
+{
+  RECIPE_STEP_NONE = 0,
+  RECIPE_STEP_MOVE,           // move to the returned position
+  RECIPE_STEP_END
+};
+
+// handler of each opcode, the top 3 bits of a command
+#define RECIPE_HANDLERS 8
+
+// A command decoded ahead of time: the handler that runs it and its
+// parameter, at the same offset as the command in recipe_code. recipe_asm
+// writes the decoded stream of the built in image next to it in flash
+// (default_recipes.c), other images are decoded into RAM.
+struct Instruction
+{
+  UINT8 handler;
+  UINT8 parameter;
+};
+
+// The firmware runs the decoded stream through the handler table, build
+// with -DRECIPE_SWITCH_DISPATCH to decode every command with a switch
+// instead and leave the stream out.
+#ifdef RECIPE_SWITCH_DISPATCH
+#define RunRecipeCommand RunRecipeSwitch
+#else
+#define RunRecipeCommand RunRecipeThreaded
+
+// decoded stream of the loaded image
+extern const struct Instruction *recipe_stream;
+
+// built in decoded stream, generated with default_recipe_image
+extern const struct Instruction default_recipe_image_stream[];
+extern const UINT16 default_recipe_image_stream_length;
+
+void DecodeRecipes(struct Instruction *stream);
+UINT8 UseRecipeStream(const struct Instruction *stream, UINT16 length);
+enum RECIPE_STEP RunRecipeThreaded(struct RecipeCursor *cursor, UINT8 *position);
+#endif
+
+void StartRecipe(struct RecipeCursor *cursor, UINT8 number);
+enum RECIPE_STEP RunRecipeSwitch(struct RecipeCursor *cursor, UINT8 *position);
+
+#endif
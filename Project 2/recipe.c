@@ -0,0 +1,278 @@
+#include "recipe.h"
+
+const UINT8 *recipe_code;
+UINT16 recipe_code_length = 0;
+UINT8 number_of_recipes = 0;
+
+// offset table of the loaded image, big endian as it is in the image
+static const UINT8 *recipe_offsets;
+UINT8 recipe_check[MAX_RECIPES];
+UINT32 recipe_ticks[MAX_RECIPES];
+
+
+/*
+ * Header: reads a two byte big endian field of an image
+ *
+ * Params: first byte of the field
+ * Return: the value
+ */
+UINT16 read_big_endian(const UINT8 *bytes)
+{
+  return (UINT16)(((UINT16)bytes[0] << 8) | bytes[1]);
+}
+
+/*
+ * Header: Maps the recipes of an image in place and verifies them. The
+ *         image is not copied, its code and offset table are used where
+ *         they are, so it has to stay there while the recipes run.
+ *         Nothing is changed unless the whole image is good, single
+ *         recipes can still be rejected (recipe_check).
+ *
+ * Params: image and its length in bytes
+ * Return: IMAGE_OK or what is wrong with the image
+ */
+enum IMAGE_STATUS LoadRecipeImage(const UINT8 *image, UINT16 length)
+{
+  UINT8 count;
+  UINT16 code_length;
+  UINT16 checksum = 0;
+  const UINT8 *code;
+  UINT16 i;
+  UINT8 j;
+
+  if(RECIPE_HEADER_SIZE > length)
+  {
+    return IMAGE_TOO_SHORT;
+  }
+
+  for(j = 0; j < 4; j++)
+  {
+    if(RECIPE_IMAGE_MAGIC[j] != image[j])
+    {
+      return IMAGE_BAD_MAGIC;
+    }
+  }
+
+  if(RECIPE_IMAGE_VERSION != image[4])
+  {
+    return IMAGE_BAD_VERSION;
+  }
+
+  count = image[5];
+  if(MAX_RECIPES < count)
+  {
+    return IMAGE_TOO_MANY_RECIPES;
+  }
+
+  code_length = read_big_endian(&image[6]);
+  if((UINT16)(length - RECIPE_HEADER_SIZE) / 2 < count
+    || length - RECIPE_HEADER_SIZE - 2 * count != code_length)
+  {
+    return IMAGE_TOO_SHORT;
+  }
+
+  code = &image[RECIPE_HEADER_SIZE + 2 * count];
+  for(i = 0; i < code_length; i++)
+  {
+    checksum += code[i];
+  }
+  if(read_big_endian(&image[8]) != checksum)
+  {
+    return IMAGE_BAD_CHECKSUM;
+  }
+
+  // recipes follow each other in the code, each one ends where the next starts
+  for(j = 0; j < count; j++)
+  {
+    UINT16 start = read_big_endian(&image[RECIPE_HEADER_SIZE + 2 * j]);
+    UINT16 end = j + 1 < count ? read_big_endian(&image[RECIPE_HEADER_SIZE + 2 * (j + 1)]) : code_length;
+    if(start > end || end > code_length)
+    {
+      return IMAGE_BAD_OFFSET;
+    }
+  }
+
+  recipe_offsets = &image[RECIPE_HEADER_SIZE];
+  recipe_code = code;
+  recipe_code_length = code_length;
+  number_of_recipes = count;
+  VerifyRecipes();
+  return IMAGE_OK;
+}
+
+/*
+ * Header: where a recipe starts in recipe_code
+ *
+ * Params: recipe number
+ * Return: its offset, the end of the code for a recipe the image does not
+ *         have
+ */
+UINT16 RecipeStart(UINT8 number)
+{
+  return number < number_of_recipes ? read_big_endian(&recipe_offsets[2 * number]) : recipe_code_length;
+}
+
+/*
+ * Header: where a recipe ends in recipe_code, recipes follow each other so
+ *         this is where the next one starts
+ *
+ * Params: recipe number
+ * Return: offset just past its last command
+ */
+UINT16 RecipeEnd(UINT8 number)
+{
+  return number < number_of_recipes ? RecipeStart(number + 1) : recipe_code_length;
+}
+
+/*
+ * Header: bounds checked read of a recipe's code, for anything that looks
+ *         at a recipe that has not been verified
+ *
+ * Params: recipe number, command number inside the recipe
+ * Return: the command, END past the end of the recipe or of the image
+ */
+UINT8 RecipeByte(UINT8 number, UINT16 pc)
+{
+  UINT16 start = RecipeStart(number);
+  if(RecipeEnd(number) - start <= pc)
+  {
+    return END;
+  }
+  return recipe_code[start + pc];
+}
+
+/*
+ * Header: checks one recipe on its own and adds up its ticks until its
+ *         END runs, or until it LOADs the next recipe
+ *
+ * Params: recipe number, its ticks and the recipe it LOADs (MAX_RECIPES if
+ *         it ends with END)
+ * Return: an enum RECIPE_CHECK
+ */
+static UINT8 check_recipe(UINT8 number, UINT32 *ticks, UINT8 *next)
+{
+  UINT16 length = RecipeEnd(number) - RecipeStart(number);
+  UINT8 in_loop = 0;
+  UINT8 loop_count = 0;
+  UINT32 loop_ticks = 0;
+  UINT16 pc;
+
+  *ticks = 0;
+  *next = MAX_RECIPES;
+  for(pc = 0; pc < length; pc++)
+  {
+    UINT8 opcode = RecipeByte(number, pc) & OPCODE_MASK;
+    UINT8 parameter = RecipeByte(number, pc) & PARAMETER_MASK;
+    UINT32 command_ticks = 1;
+
+    switch(opcode)
+    {
+      case MOV:
+        if(STEPPER_POSITIONS <= parameter)
+        {
+          return RECIPE_BAD_POSITION;
+        }
+        break;
+
+      case WAIT:
+        command_ticks = (UINT32)parameter + 1;
+        break;
+
+      case START_LOOP:
+        if(in_loop)
+        {
+          return RECIPE_NESTED_LOOP;
+        }
+        in_loop = 1;
+        loop_count = parameter;
+        loop_ticks = 0;
+        *ticks += 1;
+        continue;
+
+      case END_LOOP:
+        if(!in_loop)
+        {
+          return RECIPE_UNMATCHED_END_LOOP;
+        }
+        // the body and its END_LOOP run once more than the loop count
+        in_loop = 0;
+        *ticks += (loop_ticks + 1) * ((UINT32)loop_count + 1);
+        continue;
+
+      case END:
+        return in_loop ? RECIPE_OPEN_LOOP : RECIPE_OK;
+
+      case LOAD:
+        if(in_loop)
+        {
+          return RECIPE_OPEN_LOOP;
+        }
+        if(number_of_recipes <= parameter)
+        {
+          return RECIPE_BAD_LOAD;
+        }
+        *ticks += 1;
+        *next = parameter;
+        return RECIPE_OK;
+
+      default:
+        return RECIPE_BAD_OPCODE;
+    }
+
+    if(in_loop)
+    {
+      loop_ticks += command_ticks;
+    }
+    else
+    {
+      *ticks += command_ticks;
+    }
+  }
+  return RECIPE_NO_END;
+}
+
+/*
+ * Header: Verifies every recipe of the loaded image and works out how long
+ *         each one runs, LOAD chains included. A recipe that LOADs a
+ *         rejected recipe is rejected too, so a recipe that passes never
+ *         reaches a bad command.
+ *
+ * Params: void
+ * Return: void
+ */
+void VerifyRecipes(void)
+{
+  UINT32 ticks[MAX_RECIPES];
+  UINT8 next[MAX_RECIPES];
+  UINT8 i;
+
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    recipe_check[i] = check_recipe(i, &ticks[i], &next[i]);
+  }
+
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    UINT32 total = 0;
+    UINT8 current = i;
+    UINT8 steps;
+
+    // a chain longer than the number of recipes has come back on itself
+    recipe_ticks[i] = RECIPE_FOREVER;
+    for(steps = 0; steps <= number_of_recipes && RECIPE_OK == recipe_check[i]; steps++)
+    {
+      if(RECIPE_OK != recipe_check[current])
+      {
+        recipe_check[i] = RECIPE_LOADS_BAD_RECIPE;
+        break;
+      }
+      total += ticks[current];
+      if(MAX_RECIPES == next[current])
+      {
+        recipe_ticks[i] = total;
+        break;
+      }
+      current = next[current];
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef _recipe_
+#define _recipe_
+
+// Recipe images: every recipe of the steppers assembled by recipe_asm
+// (host tool, see recipe_asm.c) into one block of bytes, which
+// LoadRecipeImage maps in place without allocating anything.
+//
+// Layout, two byte fields are big endian so the host and the HCS12 read
+// the same image:
+//   0   'R' 'C' 'P' 'I'
+//   4   version
+//   5   number of recipes
+//   6   code length
+//   8   code checksum, sum of the code bytes
+//   10  offset of each recipe from the start of the code
+//   then the code, one byte per command: opcode in the top 3 bits,
+//   parameter in the low 5 bits
+
+// host tools and the QNX servos of Project 3 build with -DRECIPE_HOST, the
+// firmware uses the project types
+#ifdef RECIPE_HOST
+#include <stdint.h>
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+#else
+#include "types.h"
+#endif
+
+#define END ((UINT8) 0x00 << 5)
+#define MOV ((UINT8) 0x01 << 5)
+#define WAIT ((UINT8) 0x02 << 5)
+#define START_LOOP ((UINT8) 0x04 << 5)
+#define END_LOOP ((UINT8) 0x05 << 5)
+#define LOAD ((UINT8) 0x06 << 5)
+
+#define OPCODE_MASK 0xE0
+#define PARAMETER_MASK 0x1F
+
+#define STEPPER_POSITIONS 6
+
+// LOAD can name recipes 0 to 31
+#define MAX_RECIPES 32
+
+#define RECIPE_IMAGE_MAGIC "RCPI"
+#define RECIPE_IMAGE_VERSION 1
+#define RECIPE_HEADER_SIZE 10
+#define RECIPE_MAX_CODE 0xFFFF
+
+enum IMAGE_STATUS
+{
+  IMAGE_OK = 0,
+  IMAGE_TOO_SHORT,
+  IMAGE_BAD_MAGIC,
+  IMAGE_BAD_VERSION,
+  IMAGE_TOO_MANY_RECIPES,
+  IMAGE_BAD_OFFSET,
+  IMAGE_BAD_CHECKSUM
+};
+
+// What the verifier found wrong with a recipe. A recipe that passes can
+// be run without any check while it runs.
+enum RECIPE_CHECK
+{
+  RECIPE_OK = 0,
+  RECIPE_BAD_OPCODE,
+  RECIPE_BAD_POSITION,        // MOV past the last position
+  RECIPE_NESTED_LOOP,
+  RECIPE_UNMATCHED_END_LOOP,  // END_LOOP without LOOP
+  RECIPE_OPEN_LOOP,           // END or LOAD before the loop's END_LOOP
+  RECIPE_NO_END,              // runs off its end without END or LOAD
+  RECIPE_BAD_LOAD,            // LOAD of a recipe the image does not have
+  RECIPE_LOADS_BAD_RECIPE     // LOAD of a recipe that was rejected
+};
+
+// Every command takes one tick, except WAIT n which takes n + 1, and
+// nothing but pausing changes how long a recipe runs, so the ticks until
+// END are both the exact and the worst case duration. A recipe whose
+// LOADs come back to it never ends.
+#define RECIPE_FOREVER ((UINT32) 0xFFFFFFFF)
+
+// The code of every recipe of the loaded image, one after the other. It
+// is read where it is, the built in image is const and stays in flash, so
+// the only RAM a recipe needs is the tables below. A stepper keeps its PC
+// as an offset into recipe_code, each fetch is then a single indexed load.
+extern const UINT8 *recipe_code;
+extern UINT16 recipe_code_length;
+extern UINT8 number_of_recipes;
+
+// filled in by VerifyRecipes: an enum RECIPE_CHECK, and the ticks from the
+// start of the recipe until END runs, following LOADs
+extern UINT8 recipe_check[MAX_RECIPES];
+extern UINT32 recipe_ticks[MAX_RECIPES];
+
+// built in recipes, generated from recipes.txt into default_recipes.c
+extern const UINT8 default_recipe_image[];
+extern const UINT16 default_recipe_image_length;
+
+enum IMAGE_STATUS LoadRecipeImage(const UINT8 *image, UINT16 length);
+UINT16 read_big_endian(const UINT8 *bytes);
+UINT16 RecipeStart(UINT8 number);
+UINT16 RecipeEnd(UINT8 number);
+UINT8 RecipeByte(UINT8 number, UINT16 pc);
+void VerifyRecipes(void);
+
+#endif
@@ -0,0 +1,608 @@
+/******************************************************************************
+ * Recipe assembler (host tool)
+ *
+ * Turns a text recipe file into a recipe image (see recipe.h) that the
+ * steppers load as it is, so adding or changing a recipe needs no change
+ * to the firmware code.
+ *
+ * One command per line, ';' or '#' starts a comment:
+ *
+ *   RECIPE name     starts the next recipe, recipes are numbered in order
+ *   MOV n           move to position n
+ *   WAIT n          wait, takes n + 1 ticks (WAIT 0 takes one)
+ *   LOOP n          run the commands up to END_LOOP n more times
+ *   END_LOOP
+ *   END             the recipe is done
+ *   LOAD n|name     continue with another recipe, by number or name
+ *
+ * Parameters are 0 to 31, whether they make sense is checked when the
+ * image is loaded. The assembler loads the image it wrote the same way the
+ * firmware does and lists what the verifier found for each recipe, how
+ * many ticks it runs and how many events its timeline takes, a rejected
+ * recipe is reported but still written.
+ *
+ * usage: recipe_asm [-c name] [-t timelines] source image
+ *   -c  write the image as a C source defining the const array name, its
+ *       decoded stream name_stream and its timelines name_timeline_events
+ *       for playback builds, to link into the firmware (default_recipes.c),
+ *       placed in flash
+ *   -t  also write the timeline of every recipe (timeline.h) as text, one
+ *       "tick position" line per move, to look at or diff
+ *
+ * build: cc -DRECIPE_HOST -o recipe_asm recipe_asm.c recipe.c interpreter.c timeline.c
+ *
+ *****************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interpreter.h"
+#include "recipe.h"
+#include "timeline.h"
+
+#define MAX_LINE 256
+#define MAX_NAME 32
+
+struct Assembled
+{
+  char names[MAX_RECIPES][MAX_NAME];
+  UINT16 offsets[MAX_RECIPES];
+  UINT8 count;
+
+  UINT8 code[RECIPE_MAX_CODE];
+  UINT16 length;
+
+  // LOAD by name can point forward, resolved once every recipe is known
+  char load_names[RECIPE_MAX_CODE][MAX_NAME];
+  int load_lines[RECIPE_MAX_CODE];
+};
+
+static const char *source_name;
+static struct Assembled assembled;
+
+// timelines of the image, written with it for playback builds
+static struct TimelineEvent timeline_table[RECIPE_MAX_CODE];
+static UINT16 timeline_table_start[MAX_RECIPES + 1];
+
+
+/*
+ * Header: reports an error in the source and stops
+ *
+ * Params: line number, message and what it is about
+ * Return: does not return
+ */
+static void fail(int line, const char *message, const char *detail)
+{
+  fprintf(stderr, "%s:%d: %s%s\n", source_name, line, message, detail);
+  exit(EXIT_FAILURE);
+}
+
+/*
+ * Header: parses a parameter 0 to 31
+ *
+ * Params: text, line number for errors
+ * Return: the parameter
+ */
+static UINT8 parameter(const char *text, int line)
+{
+  char *end;
+  long value;
+
+  if(NULL == text)
+  {
+    fail(line, "missing parameter", "");
+  }
+  value = strtol(text, &end, 10);
+  if('\0' != *end || value < 0 || value > PARAMETER_MASK)
+  {
+    fail(line, "parameter must be 0 to 31: ", text);
+  }
+  return (UINT8)value;
+}
+
+/*
+ * Header: adds one command to the current recipe
+ *
+ * Params: command byte, line number for errors
+ * Return: void
+ */
+static void emit(UINT8 command, int line)
+{
+  if(0 == assembled.count)
+  {
+    fail(line, "command before the first RECIPE", "");
+  }
+  if(RECIPE_MAX_CODE - 2 * MAX_RECIPES - RECIPE_HEADER_SIZE <= assembled.length)
+  {
+    fail(line, "image too large", "");
+  }
+  assembled.code[assembled.length++] = command;
+}
+
+/*
+ * Header: assembles one line
+ *
+ * Params: line text (changed), line number
+ * Return: void
+ */
+static void assemble_line(char *text, int line)
+{
+  char *comment = strpbrk(text, ";#");
+  char *mnemonic;
+  char *argument;
+  char *extra;
+  UINT8 i;
+
+  if(NULL != comment)
+  {
+    *comment = '\0';
+  }
+
+  mnemonic = strtok(text, " \t\r\n");
+  if(NULL == mnemonic)
+  {
+    return;
+  }
+  argument = strtok(NULL, " \t\r\n");
+  extra = strtok(NULL, " \t\r\n");
+  if(NULL != extra)
+  {
+    fail(line, "unexpected ", extra);
+  }
+  for(i = 0; '\0' != mnemonic[i]; i++)
+  {
+    mnemonic[i] = (char)toupper((unsigned char)mnemonic[i]);
+  }
+
+  if(0 == strcmp(mnemonic, "RECIPE"))
+  {
+    if(NULL == argument || MAX_NAME <= strlen(argument))
+    {
+      fail(line, "RECIPE needs a name of at most 31 characters", "");
+    }
+    if(MAX_RECIPES == assembled.count)
+    {
+      fail(line, "too many recipes", "");
+    }
+    for(i = 0; i < assembled.count; i++)
+    {
+      if(0 == strcmp(assembled.names[i], argument))
+      {
+        fail(line, "recipe defined twice: ", argument);
+      }
+    }
+    strcpy(assembled.names[assembled.count], argument);
+    assembled.offsets[assembled.count] = assembled.length;
+    assembled.count++;
+  }
+  else if(0 == strcmp(mnemonic, "MOV"))
+  {
+    emit(MOV | parameter(argument, line), line);
+  }
+  else if(0 == strcmp(mnemonic, "WAIT"))
+  {
+    emit(WAIT | parameter(argument, line), line);
+  }
+  else if(0 == strcmp(mnemonic, "LOOP") || 0 == strcmp(mnemonic, "START_LOOP"))
+  {
+    emit(START_LOOP | parameter(argument, line), line);
+  }
+  else if(0 == strcmp(mnemonic, "END_LOOP") && NULL == argument)
+  {
+    emit(END_LOOP, line);
+  }
+  else if(0 == strcmp(mnemonic, "END") && NULL == argument)
+  {
+    emit(END, line);
+  }
+  else if(0 == strcmp(mnemonic, "LOAD"))
+  {
+    if(NULL != argument && isdigit((unsigned char)argument[0]))
+    {
+      emit(LOAD | parameter(argument, line), line);
+    }
+    else
+    {
+      if(NULL == argument || MAX_NAME <= strlen(argument))
+      {
+        fail(line, "LOAD needs a recipe number or name", "");
+      }
+      strcpy(assembled.load_names[assembled.length], argument);
+      assembled.load_lines[assembled.length] = line;
+      emit(LOAD, line);
+    }
+  }
+  else
+  {
+    fail(line, "unknown command ", mnemonic);
+  }
+}
+
+/*
+ * Header: fills in the recipe numbers of LOAD by name
+ *
+ * Params: void
+ * Return: void
+ */
+static void resolve_loads(void)
+{
+  UINT16 pc;
+  UINT8 i;
+
+  for(pc = 0; pc < assembled.length; pc++)
+  {
+    if('\0' == assembled.load_names[pc][0])
+    {
+      continue;
+    }
+    for(i = 0; i < assembled.count; i++)
+    {
+      if(0 == strcmp(assembled.names[i], assembled.load_names[pc]))
+      {
+        break;
+      }
+    }
+    if(assembled.count == i)
+    {
+      fail(assembled.load_lines[pc], "no recipe named ", assembled.load_names[pc]);
+    }
+    assembled.code[pc] = LOAD | i;
+  }
+}
+
+/*
+ * Header: lays out the image as described in recipe.h
+ *
+ * Params: buffer of at least RECIPE_MAX_CODE bytes
+ * Return: image length
+ */
+static UINT16 build_image(UINT8 *image)
+{
+  UINT16 checksum = 0;
+  UINT16 position = RECIPE_HEADER_SIZE;
+  UINT16 pc;
+  UINT8 i;
+
+  for(pc = 0; pc < assembled.length; pc++)
+  {
+    checksum += assembled.code[pc];
+  }
+
+  memcpy(image, RECIPE_IMAGE_MAGIC, 4);
+  image[4] = RECIPE_IMAGE_VERSION;
+  image[5] = assembled.count;
+  image[6] = (UINT8)(assembled.length >> 8);
+  image[7] = (UINT8)assembled.length;
+  image[8] = (UINT8)(checksum >> 8);
+  image[9] = (UINT8)checksum;
+  for(i = 0; i < assembled.count; i++)
+  {
+    image[position++] = (UINT8)(assembled.offsets[i] >> 8);
+    image[position++] = (UINT8)assembled.offsets[i];
+  }
+  memcpy(&image[position], assembled.code, assembled.length);
+  return position + assembled.length;
+}
+
+/*
+ * Header: Writes the image as a C array with one recipe per line, its
+ *         decoded stream (interpreter.h) and its timelines (timeline.h)
+ *         the same way. The image has to be loaded and its timelines
+ *         compiled.
+ *
+ * Params: file, array name, image and its length
+ * Return: 0 if written
+ */
+static int write_c_source(FILE *file, const char *name, const UINT8 *image, UINT16 length)
+{
+  static struct Instruction stream[RECIPE_MAX_CODE];
+  UINT16 position = RECIPE_HEADER_SIZE + 2 * assembled.count;
+  UINT16 i;
+  UINT8 j;
+
+  DecodeRecipes(stream);
+
+  fprintf(file, "/* generated by recipe_asm from %s, do not edit */\n\n", source_name);
+  fprintf(file, "#include \"timeline.h\"\n\n");
+  fprintf(file, "// the image, its decoded stream and its timelines are used where they\n");
+  fprintf(file, "// are, keep them in flash with the other constants so none of it takes RAM\n");
+  fprintf(file, "#ifndef RECIPE_HOST\n#pragma push\n#pragma CONST_SEG ROM_VAR\n#endif\n\n");
+  fprintf(file, "const UINT8 %s[] =\n{\n  /* header */\n ", name);
+  for(i = 0; i < position; i++)
+  {
+    fprintf(file, " 0x%02X,", image[i]);
+  }
+  fprintf(file, "\n");
+  for(j = 0; j < assembled.count; j++)
+  {
+    UINT16 end = j + 1 < assembled.count ? assembled.offsets[j + 1] : assembled.length;
+    fprintf(file, "  /* %u %s */\n ", j, assembled.names[j]);
+    for(i = assembled.offsets[j]; i < end; i++)
+    {
+      fprintf(file, " 0x%02X,", image[position + i]);
+    }
+    fprintf(file, "\n");
+  }
+  fprintf(file, "};\n\nconst UINT16 %s_length = %u;\n", name, length);
+
+  fprintf(file, "\n#ifndef RECIPE_SWITCH_DISPATCH\n");
+  fprintf(file, "const struct Instruction %s_stream[] =\n{\n", name);
+  for(j = 0; j < assembled.count; j++)
+  {
+    UINT16 end = j + 1 < assembled.count ? assembled.offsets[j + 1] : assembled.length;
+    fprintf(file, "  /* %u %s */\n ", j, assembled.names[j]);
+    for(i = assembled.offsets[j]; i < end; i++)
+    {
+      fprintf(file, " {%u, %u},", stream[i].handler, stream[i].parameter);
+    }
+    fprintf(file, "\n");
+  }
+  fprintf(file, "};\n\nconst UINT16 %s_stream_length = %u;\n#endif\n", name, assembled.length);
+
+  fprintf(file, "\n#ifdef RECIPE_PLAYBACK\n");
+  fprintf(file, "const struct TimelineEvent %s_timeline_events[] =\n{\n", name);
+  for(j = 0; j < assembled.count; j++)
+  {
+    // rejected, runs forever or did not fit
+    if(timeline_start[j] == timeline_start[j + 1])
+    {
+      fprintf(file, "  /* %u %s, none */\n", j, assembled.names[j]);
+      continue;
+    }
+    fprintf(file, "  /* %u %s */\n ", j, assembled.names[j]);
+    for(i = timeline_start[j]; i < timeline_start[j + 1]; i++)
+    {
+      fprintf(file, " {%lu, 0x%02X},", (unsigned long)timeline_events[i].tick, timeline_events[i].position);
+    }
+    fprintf(file, "\n");
+  }
+  if(0 == timeline_start[assembled.count])
+  {
+    // no recipe has a timeline, C has no empty arrays
+    fprintf(file, "  {0, 0x%02X}\n", TIMELINE_END);
+  }
+  fprintf(file, "};\n\nconst UINT16 %s_timeline_start[] =\n{\n ", name);
+  for(j = 0; j <= assembled.count; j++)
+  {
+    fprintf(file, " %u,", timeline_start[j]);
+  }
+  fprintf(file, "\n};\n\nconst UINT8 %s_timeline_recipes = %u;\n#endif\n", name, assembled.count);
+  fprintf(file, "\n#ifndef RECIPE_HOST\n#pragma pop\n#endif\n");
+  return ferror(file);
+}
+
+/*
+ * Header: Copies text written with '\n' ending every line with "\r\n",
+ *         the line ending of the firmware sources, so regenerating
+ *         default_recipes.c gives the same file on any host.
+ *
+ * Params: text to copy, rewound first, and the binary file to copy it to
+ * Return: 0 if copied
+ */
+static int copy_crlf(FILE *text, FILE *file)
+{
+  int c;
+
+  rewind(text);
+  while(EOF != (c = getc(text)))
+  {
+    if('\n' == c)
+    {
+      putc('\r', file);
+    }
+    putc(c, file);
+  }
+  return ferror(text) || ferror(file);
+}
+
+/*
+ * Header: loads the image like the firmware does and lists each recipe
+ *
+ * Params: image and its length
+ * Return: 0 if the image loaded
+ */
+static int report(const UINT8 *image, UINT16 length)
+{
+  static const char *checks[] =
+  {
+    "ok", "bad opcode", "MOV past the last position", "nested loop",
+    "END_LOOP without LOOP", "loop not closed", "no END", "LOAD of a missing recipe",
+    "LOADs a rejected recipe"
+  };
+  enum IMAGE_STATUS status = LoadRecipeImage(image, length);
+  UINT8 missing;
+  UINT8 i;
+
+  if(IMAGE_OK != status)
+  {
+    fprintf(stderr, "image rejected (%d)\n", status);
+    return 1;
+  }
+  missing = CompileTimelines(timeline_table, RECIPE_MAX_CODE, timeline_table_start);
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    printf("%3u %-*s %s", i, MAX_NAME, assembled.names[i], checks[recipe_check[i]]);
+    if(RECIPE_OK != recipe_check[i])
+    {
+      printf("\n");
+    }
+    else if(RECIPE_FOREVER == recipe_ticks[i])
+    {
+      printf(", runs forever\n");
+    }
+    else if(!HasTimeline(i))
+    {
+      printf(", %lu ticks, no room for its timeline\n", (unsigned long)recipe_ticks[i]);
+    }
+    else
+    {
+      printf(", %lu ticks, %u timeline events\n", (unsigned long)recipe_ticks[i], timeline_start[i + 1] - timeline_start[i]);
+    }
+  }
+
+  // the image still loads but not everything runs
+  if(0 != missing)
+  {
+    fprintf(stderr, "warning: %u recipe timelines do not fit the %d events of the timeline table, those recipes go to ERROR in a playback build\n",
+      missing, RECIPE_MAX_CODE);
+  }
+  return 0;
+}
+
+/*
+ * Header: writes the timeline of every recipe of the loaded image
+ *
+ * Params: file
+ * Return: 0 if written
+ */
+static int write_timelines(FILE *file)
+{
+  static struct TimelineEvent events[RECIPE_MAX_CODE];
+  UINT16 count;
+  UINT16 i;
+  UINT8 j;
+
+  for(j = 0; j < number_of_recipes; j++)
+  {
+    fprintf(file, "recipe %u %s\n", j, assembled.names[j]);
+    if(RECIPE_OK != recipe_check[j])
+    {
+      fprintf(file, "  rejected\n");
+      continue;
+    }
+    if(RECIPE_FOREVER == recipe_ticks[j])
+    {
+      fprintf(file, "  runs forever\n");
+      continue;
+    }
+    count = CompileTimeline(j, events, RECIPE_MAX_CODE);
+    if(0 == count)
+    {
+      fprintf(file, "  too many moves\n");
+      continue;
+    }
+    for(i = 0; i < count; i++)
+    {
+      if(TIMELINE_END == events[i].position)
+      {
+        fprintf(file, "  %lu END\n", (unsigned long)events[i].tick);
+      }
+      else if(TIMELINE_IS_LOAD(events[i].position))
+      {
+        fprintf(file, "  %lu LOAD %u\n", (unsigned long)events[i].tick, events[i].position & PARAMETER_MASK);
+      }
+      else
+      {
+        fprintf(file, "  %lu %u\n", (unsigned long)events[i].tick, events[i].position);
+      }
+    }
+  }
+  return ferror(file);
+}
+
+int main(int argc, char *argv[])
+{
+  static UINT8 image[RECIPE_MAX_CODE];
+  const char *array_name = NULL;
+  const char *timeline_name = NULL;
+  char text[MAX_LINE];
+  FILE *source;
+  FILE *output;
+  int line = 0;
+  int first = 1;
+  UINT16 length;
+  int failed;
+
+  while(argc >= first + 2 && '-' == argv[first][0])
+  {
+    if(0 == strcmp(argv[first], "-c"))
+    {
+      array_name = argv[first + 1];
+    }
+    else if(0 == strcmp(argv[first], "-t"))
+    {
+      timeline_name = argv[first + 1];
+    }
+    else
+    {
+      break;
+    }
+    first += 2;
+  }
+  if(argc != first + 2)
+  {
+    fprintf(stderr, "usage: %s [-c name] [-t timelines] source image\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  source_name = argv[first];
+  source = fopen(source_name, "r");
+  if(NULL == source)
+  {
+    fprintf(stderr, "cannot open %s\n", source_name);
+    return EXIT_FAILURE;
+  }
+  while(NULL != fgets(text, sizeof(text), source))
+  {
+    line++;
+    assemble_line(text, line);
+  }
+  fclose(source);
+
+  if(0 == assembled.count)
+  {
+    fail(line, "no recipes", "");
+  }
+  resolve_loads();
+  length = build_image(image);
+
+  printf("%u recipes, %u bytes of code, %u byte image\n", assembled.count, assembled.length, length);
+  if(0 != report(image, length))
+  {
+    return EXIT_FAILURE;
+  }
+
+  output = fopen(argv[first + 1], "wb");
+  if(NULL == output)
+  {
+    fprintf(stderr, "cannot create %s\n", argv[first + 1]);
+    return EXIT_FAILURE;
+  }
+  if(NULL == array_name)
+  {
+    failed = length != fwrite(image, 1, length, output);
+  }
+  else
+  {
+    FILE *text = tmpfile();
+    failed = NULL == text || write_c_source(text, array_name, image, length) || copy_crlf(text, output);
+    if(NULL != text)
+    {
+      fclose(text);
+    }
+  }
+  if(0 != fclose(output) || failed)
+  {
+    fprintf(stderr, "cannot write %s\n", argv[first + 1]);
+    return EXIT_FAILURE;
+  }
+
+  if(NULL != timeline_name)
+  {
+    output = fopen(timeline_name, "w");
+    if(NULL == output)
+    {
+      fprintf(stderr, "cannot create %s\n", timeline_name);
+      return EXIT_FAILURE;
+    }
+    failed = write_timelines(output);
+    if(0 != fclose(output) || failed)
+    {
+      fprintf(stderr, "cannot write %s\n", timeline_name);
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
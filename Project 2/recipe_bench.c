@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Recipe interpreter benchmark (host tool)
+ *
+ * Runs the verified recipes of an image on many channels at once, one
+ * command per channel per tick like the servo timer does, and measures
+ * how many commands per second each dispatch of interpreter.c runs:
+ *
+ *   switch    decodes every command from recipe_code (RunRecipeSwitch)
+ *   threaded  handler table over the stream decoded at load time
+ *             (RunRecipeThreaded)
+ *
+ * A recipe that ends is started again, so the mix of commands stays that
+ * of the recipes. Output is CSV, one line per dispatch.
+ *
+ * usage: recipe_bench [-n ticks] [-c channels] [image]
+ *   image  recipe image written by recipe_asm, the built in recipes
+ *          without one
+ *
+ * build: cc -O2 -DRECIPE_HOST -o recipe_bench recipe_bench.c interpreter.c
+ *        recipe.c default_recipes.c
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "interpreter.h"
+
+#ifdef RECIPE_SWITCH_DISPATCH
+#error "recipe_bench compares both dispatches, build it without -DRECIPE_SWITCH_DISPATCH"
+#endif
+
+#define DEFAULT_TICKS 100000
+#define DEFAULT_CHANNELS 64
+
+typedef enum RECIPE_STEP (*dispatch)(struct RecipeCursor *cursor, UINT8 *position);
+
+// positions the channels moved to, so the work cannot be optimized away
+static volatile UINT8 positions;
+
+
+/*
+ * Header: runs every channel for a number of ticks
+ *
+ * Params: dispatch, channels, their recipes, ticks, seconds taken
+ * Return: commands run
+ */
+static unsigned long run(dispatch run_command, struct RecipeCursor *cursors, const UINT8 *numbers,
+  unsigned long channels, unsigned long ticks, double *seconds)
+{
+  struct timespec start, end;
+  unsigned long commands = 0;
+  unsigned long tick;
+  unsigned long i;
+  UINT8 position;
+
+  for(i = 0; i < channels; i++)
+  {
+    StartRecipe(&cursors[i], numbers[i]);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(tick = 0; tick < ticks; tick++)
+  {
+    for(i = 0; i < channels; i++)
+    {
+      switch(run_command(&cursors[i], &position))
+      {
+        case RECIPE_STEP_MOVE:
+          positions += position;
+          break;
+
+        case RECIPE_STEP_END:
+          StartRecipe(&cursors[i], numbers[i]);
+          break;
+
+        case RECIPE_STEP_NONE:
+          break;
+      }
+    }
+    commands += channels;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  *seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  return commands;
+}
+
+int main(int argc, char *argv[])
+{
+  static UINT8 image[RECIPE_MAX_CODE];
+  const UINT8 *loaded = default_recipe_image;
+  UINT16 length = default_recipe_image_length;
+  unsigned long ticks = DEFAULT_TICKS;
+  unsigned long channels = DEFAULT_CHANNELS;
+  struct RecipeCursor *cursors;
+  struct Instruction *stream;
+  UINT8 *numbers;
+  UINT8 runnable[MAX_RECIPES];
+  UINT8 count = 0;
+  unsigned long commands;
+  double seconds;
+  enum IMAGE_STATUS status;
+  unsigned long i;
+  int arg;
+
+  for(arg = 1; arg < argc && '-' == argv[arg][0]; arg += 2)
+  {
+    if(arg + 1 == argc || ('n' != argv[arg][1] && 'c' != argv[arg][1]))
+    {
+      fprintf(stderr, "usage: %s [-n ticks] [-c channels] [image]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+    if('n' == argv[arg][1])
+    {
+      ticks = strtoul(argv[arg + 1], NULL, 10);
+    }
+    else
+    {
+      channels = strtoul(argv[arg + 1], NULL, 10);
+    }
+  }
+  if(arg < argc)
+  {
+    FILE *file = fopen(argv[arg], "rb");
+    if(NULL == file)
+    {
+      fprintf(stderr, "cannot open %s\n", argv[arg]);
+      return EXIT_FAILURE;
+    }
+    length = (UINT16)fread(image, 1, sizeof(image), file);
+    fclose(file);
+    loaded = image;
+  }
+
+  status = LoadRecipeImage(loaded, length);
+  if(IMAGE_OK != status)
+  {
+    fprintf(stderr, "image rejected (%d)\n", status);
+    return EXIT_FAILURE;
+  }
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    if(RECIPE_OK == recipe_check[i])
+    {
+      runnable[count++] = (UINT8)i;
+    }
+  }
+  if(0 == count || 0 == channels)
+  {
+    fprintf(stderr, "nothing to run\n");
+    return EXIT_FAILURE;
+  }
+
+  // channels take the runnable recipes in turn
+  cursors = malloc(channels * sizeof(*cursors));
+  numbers = malloc(channels);
+  stream = malloc((recipe_code_length + 1) * sizeof(*stream));
+  if(NULL == cursors || NULL == numbers || NULL == stream)
+  {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+  for(i = 0; i < channels; i++)
+  {
+    numbers[i] = runnable[i % count];
+  }
+  DecodeRecipes(stream);
+
+  printf("dispatch,channels,commands,seconds,commands_per_second\n");
+  commands = run(RunRecipeSwitch, cursors, numbers, channels, ticks, &seconds);
+  printf("switch,%lu,%lu,%g,%g\n", channels, commands, seconds, commands / seconds);
+  commands = run(RunRecipeThreaded, cursors, numbers, channels, ticks, &seconds);
+  printf("threaded,%lu,%lu,%g,%g\n", channels, commands, seconds, commands / seconds);
+
+  free(cursors);
+  free(numbers);
+  free(stream);
+  return EXIT_SUCCESS;
+}
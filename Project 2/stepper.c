@@ -1,11 +1,11 @@
 #include "stepper.h"
 
 UINT8 duty_for_position[STEPPER_POSITIONS] = {5,9,13,17,20,24};
-UINT8 **recipe;
 
 
 /*
- * Header: Initializes the recipe table
+ * Header: Loads the recipe table from the built in recipe image
+ *         (recipes.txt, assembled into default_recipes.c)
  *
  * Params: void
  * Return: void
@@ -13,84 +13,27 @@ UINT8 **recipe;
 
 void InitializeRecipe()
 {
-	recipe = malloc(sizeof(UINT8 *) * NO_OF_RECIPES);
-	
-	
-	/* Verify default time delay */
-	recipe[0] = malloc(sizeof(UINT8) * 4);
-	recipe[0][0] = MOV|0;
-	recipe[0][1] = MOV|5;
-	recipe[0][2] = MOV|0;
-	recipe[0][3] = END;
-	
-	/* Verify default loop behavior */
-	recipe[1] = malloc(sizeof(UINT8) * 7);
-	recipe[1][0] = MOV|3;
-	recipe[1][1] = START_LOOP|0;
-	recipe[1][2] = MOV|1;
-	recipe[1][3] = MOV|4;
-	recipe[1][4] = END_LOOP;
-	recipe[1][5] = MOV|0;
-	recipe[1][6] = END;
-	
-	/* Verify wait 0 */
-	recipe[2] = malloc(sizeof(UINT8) * 4);
-	recipe[2][0] = MOV|2;
-	recipe[2][1] = WAIT|0;
-	recipe[2][2] = MOV|3;
-	recipe[2][3] = END;
-	
-	/* 9.3 second delay */
-	recipe[3] = malloc(sizeof(UINT8) * 7);
-	recipe[3][0] = MOV|2;
-	recipe[3][1] = MOV|3;
-	recipe[3][2] = WAIT|31;
-	recipe[3][3] = WAIT|31;
-	recipe[3][4] = WAIT|31;
-	recipe[3][5] = MOV|4;
-	recipe[3][6] = END; 
-	
-	/* Every position */
-	recipe[4] = malloc(sizeof(UINT8) * 12);
-	recipe[4][0] = MOV|0;
-	recipe[4][1] = WAIT|10;
-	recipe[4][2] = MOV|1;
-	recipe[4][3] = WAIT|10;
-	recipe[4][4] = MOV|2;
-	recipe[4][5] = WAIT|10;
-	recipe[4][6] = MOV|3;
-	recipe[4][7] = WAIT|10;
-	recipe[4][8] = MOV|4;
-	recipe[4][9] = WAIT|10;
-	recipe[4][10] = MOV|5;
-	recipe[4][11] = END;
-	
-	
-	/* Immediate end */
-	recipe[5] = malloc(sizeof(UINT8) * 3);
-	recipe[5][0] = END;
-	recipe[5][1] = MOV|3;
-	recipe[5][2] = END;
-	
-	/* Recipe command error */
-	recipe[6] = malloc(sizeof(UINT8) * 4);
-	recipe[6][0] = MOV|0;
-	recipe[6][1] = MOV|5;
-	recipe[6][2] = MOV|6;
-	recipe[6][3] = END;
-  
-  /* Nested Loop Error */
-  recipe[7] = malloc(sizeof(UINT8) * 2);
-  recipe[7][0] = START_LOOP|1;
-  recipe[7][1] = START_LOOP|1;
-  recipe[7][2] = END; 
-
-  /* Recipe with new OPcode */	
-	recipe[8] = malloc(sizeof(UINT8) * 3);
-	recipe[8][0] = MOV|5;
-	recipe[8][1] = WAIT|2;
-	recipe[8][2] = LOAD|4;
-	
+  enum IMAGE_STATUS status = LoadRecipeImage(default_recipe_image, default_recipe_image_length);
+  if(IMAGE_OK != status)
+  {
+    printf("recipe image rejected (%d)\r\n", status);
+  }
+#ifndef RECIPE_SWITCH_DISPATCH
+  else if(0 != UseRecipeStream(default_recipe_image_stream, default_recipe_image_stream_length))
+  {
+    // default_recipes.c is stale, no recipe can run
+    printf("decoded recipes do not match the image\r\n");
+    number_of_recipes = 0;
+  }
+#endif
+#ifdef RECIPE_PLAYBACK
+  else if(0 != UseTimelines(default_recipe_image_timeline_events, default_recipe_image_timeline_start, default_recipe_image_timeline_recipes))
+  {
+    // default_recipes.c is stale, no recipe can run
+    printf("recipe timelines do not match the image\r\n");
+    number_of_recipes = 0;
+  }
+#endif
 }
 
 /*
@@ -103,13 +46,58 @@ void InitializeRecipe()
 void set_stepper(struct Stepper *stepper, UINT8 pwm, UINT8 current_recipe) 
 {
   stepper->pwm_channel = pwm;
-  stepper->state = BEGIN;                                                                                                       
-  stepper->recipe_number = current_recipe;  
-  stepper->PC = 0;
-  stepper->WC = 0;
+  stepper->cursor.recipe_number = current_recipe;  
+  restart_recipe(stepper);
+  if(RUN == stepper->state)
+  {
+    stepper->state = BEGIN;
+  }
   move(stepper,0);
 }
 
+/*
+ * Header: start the stepper's recipe from the top, or go to ERROR if the
+ *         recipe was rejected when it was loaded
+ *
+ * Params: stepper motor 1 or 2
+ * Return: void
+ */
+
+void restart_recipe(struct Stepper *stepper) 
+{
+  UINT8 number = stepper->cursor.recipe_number;
+  
+  StartRecipe(&stepper->cursor, number);
+  
+  if(number_of_recipes <= number)
+  {
+    stepper->error_encountered = RECIPE_COMMAND_ERROR;
+    stepper->state = ERROR;
+  }
+  else if(RECIPE_OK != recipe_check[number])
+  {
+    stepper->error_encountered = RECIPE_NESTED_LOOP == recipe_check[number] ? NESTED_LOOP_ERROR : RECIPE_COMMAND_ERROR;
+    stepper->state = ERROR;
+  }
+#ifdef RECIPE_PLAYBACK
+  else if(!HasTimeline(number))
+  {
+    // runs forever or did not fit, there is no timeline to play
+    stepper->error_encountered = RECIPE_COMMAND_ERROR;
+    stepper->state = ERROR;
+  }
+#endif
+  else
+  {
+#ifdef RECIPE_PLAYBACK
+    stepper->event = timeline_start[number];
+    stepper->tick = 0;
+#endif
+    stepper->error_encountered = NO_ERROR;
+    stepper->state = RUN;
+  }
+}
+
 
 /*
  * Header: move the motor
@@ -143,109 +131,68 @@ void move(struct Stepper *stepper,UINT8 position)
 }
 
 /*
- * Header: run the next instruction 
+ * Header: run the next instruction (interpreter.c). Recipes were verified
+ *         when they were loaded (VerifyRecipes) and a rejected one is never
+ *         started, so nothing is checked here.
  *
  * Params: stepper motor 1 or 2
  * Return: void
  */
 void run_next_command(struct Stepper *stepper) 
 {
-    UINT8 command = recipe[stepper->recipe_number][stepper->PC];
-    UINT8 opcode = command & 0xE0;
-    UINT8 parameter = command & 0x1F;
-    
-    //printf("command %d opcode %d parameter %d\r\n",command,opcode,parameter);
+    UINT8 position;
     
-    switch(opcode) 
+    switch(RunRecipeCommand(&stepper->cursor, &position)) 
     {
-      case MOV:
-        //check parameter validity
-        if(STEPPER_POSITIONS <= parameter ) 
-        {
-          //printf("Recipe command error encountered");
-          stepper->error_encountered = RECIPE_COMMAND_ERROR;
-          stepper->state = ERROR;    
-        } 
-        else
-        {
-          //printf("Moving to %d \r\n",parameter);
-          move(stepper,parameter);
-          stepper->PC++;
-        }
-        break;
-        
-      case WAIT:
-        if(0 == stepper->WC)
-        {
-          stepper->WC = parameter;
-        }
-        else
-        {
-          stepper->WC--;
-          if(0 == stepper->WC)
-          {
-            stepper->PC++;
-          }
-        }
-        //printf("Waiting for %d \r\n",stepper->WC);
+      case RECIPE_STEP_MOVE:
+        //printf("Moving to %d \r\n",position);
+        move(stepper,position);
         break;
       
-      case START_LOOP: 
-        if(0 != stepper->LPC)
-        {
-          stepper->error_encountered = NESTED_LOOP_ERROR;
-          stepper->state = ERROR;    
-        }
-        else
-        {  
-          //printf("Loop started for %d times \r\n",parameter);
-          stepper->LPC = parameter;
-          stepper->LPS = stepper->PC + 1;
-          stepper->PC++;
-        }
-        break;
-      
-      case END_LOOP:
-        if(0 == stepper->LPC)
-        {
-          //printf("Loop completed \r\n");
-          stepper->PC++;
-        } 
-        else
-        {
-          stepper->LPC--;
-          stepper->PC = stepper->LPS;
-          //printf("will Loop %d more times \r\n",stepper->LPC); 
-        }
-        break;
-      
-      case END:
+      case RECIPE_STEP_END:
         stepper->state = RECIPE_END;
         //printf("Done \r\n");
         break;
         
-      case LOAD:
-        if(NO_OF_RECIPES >= parameter)
-        {
-          stepper->PC = 0;
-          stepper->recipe_number = parameter;
-          stepper->state = RUN;
-        } 
-        else 
-        {
-          stepper->error_encountered = RECIPE_COMMAND_ERROR;
-          stepper->state = ERROR;
-        }
-        break;
-        
-      
-      default:
-        stepper->error_encountered = RECIPE_COMMAND_ERROR;
-        stepper->state = ERROR;
+      case RECIPE_STEP_NONE:
         break;
     }
 }
   
+#ifdef RECIPE_PLAYBACK
+/*
+ * Header: play the recipe's timeline (timeline.c) instead of running its
+ *         commands, the next move happens once its tick is due
+ *
+ * Params: stepper motor 1 or 2
+ * Return: void
+ */
+void play_next_event(struct Stepper *stepper) 
+{
+    const struct TimelineEvent *event = &timeline_events[stepper->event];
+    
+    if(event->tick == stepper->tick)
+    {
+      if(TIMELINE_END == event->position)
+      {
+        stepper->state = RECIPE_END;
+        return;
+      }
+      if(TIMELINE_IS_LOAD(event->position))
+      {
+        // B restarts the recipe that was loaded, as with the interpreter
+        stepper->cursor.recipe_number = event->position & PARAMETER_MASK;
+      }
+      else
+      {
+        move(stepper,event->position);
+      }
+      stepper->event++;
+    }
+    stepper->tick++;
+}
+#endif
+
 /*
  * Header: take appropriate action 
  *
@@ -259,7 +206,11 @@ UINT8 take_action(struct Stepper *stepper)
   switch(stepper->state)
   {
     case RUN:
+#ifdef RECIPE_PLAYBACK
+      play_next_event(stepper);
+#else
       run_next_command(stepper);
+#endif
       break;
     
     case BEGIN:
@@ -383,8 +334,7 @@ void update_state(struct Stepper *stepper, UINT8 input)
           
         case 'B':
         case 'b':
-          stepper->PC = 0;
-          stepper->state = RUN;
+          restart_recipe(stepper);
           break;
       }
       break;
@@ -412,8 +362,7 @@ void update_state(struct Stepper *stepper, UINT8 input)
           
         case 'B':
         case 'b':
-          stepper->PC = 0;
-          stepper->state = RUN;
+          restart_recipe(stepper);
           break;
       }
       break;
@@ -433,8 +382,7 @@ void update_state(struct Stepper *stepper, UINT8 input)
           
         case 'B':
         case 'b':
-          stepper->PC = 0;
-          stepper->state = RUN;
+          restart_recipe(stepper);
           break;
       }
       break;
@@ -454,8 +402,7 @@ void update_state(struct Stepper *stepper, UINT8 input)
         
         case 'B':
         case 'b':
-          stepper->PC = 0;
-          stepper->state = RUN;
+          restart_recipe(stepper);
           break;
       }
       break;
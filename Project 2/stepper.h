@@ -2,8 +2,9 @@
 #define _stepper_
 
 #include <hidef.h>      /* common defines and macros */
-#include <stdlib.h>
 
+#include "interpreter.h"
+#include "timeline.h"
 #include "serial.h"
 #include "derivative.h" /* derivative-specific definitions */
 #include "types.h"
@@ -11,17 +12,6 @@
 #define PWM_CHANNEL0 0
 #define PWM_CHANNEL1 1
 
-#define STEPPER_POSITIONS 6
-
-#define NO_OF_RECIPES 9
-
-#define END ((UINT8) 0x00 << 5)
-#define MOV ((UINT8) 0x01 << 5) 
-#define WAIT ((UINT8) 0x02 << 5) 
-#define START_LOOP ((UINT8) 0x04 << 5)
-#define END_LOOP ((UINT8) 0x05 << 5) 
-#define LOAD ((UINT8) 0x06 << 5)
-
 #define COMMAND_ERROR_LED ((UINT8) 0x01 << 3)
 #define NESTED_ERROR_LED ((UINT8) 0x01 << 2)
 #define RECIPE_END_LED ((UINT8) 0x01 << 1)
@@ -46,8 +36,14 @@ typedef enum ERROR_ENCOUTERED
 
 struct Stepper 
 {
-  // pointer to script to be ran on stepper
-  UINT8 recipe_number;
+  // recipe being ran on stepper and where it is
+  struct RecipeCursor cursor;
+  
+#ifdef RECIPE_PLAYBACK
+  // next event of the recipe's timeline and ticks since the recipe started
+  UINT16 event;
+  UINT32 tick;
+#endif
   
   // state
   enum State state;
@@ -55,18 +51,6 @@ struct Stepper
   // Current position of stepper
   UINT8 position;
   
-  // Program counter
-  UINT8 PC; 
-  
-  // Wait counter
-  UINT8 WC;
-  
-  // Loop start position
-  UINT8 LPS;
-  
-  // Loop counter
-  UINT8 LPC;
-  
   // PWM channel
   UINT8 pwm_channel;
   
@@ -80,6 +64,10 @@ void set_stepper(struct Stepper *stepper, UINT8 pwm, UINT8 recipe_no);
 void move(struct Stepper *stepper,UINT8 position);
 UINT8 take_action(struct Stepper *stepper);
 void run_next_command(struct Stepper *stepper);
+#ifdef RECIPE_PLAYBACK
+void play_next_event(struct Stepper *stepper);
+#endif
+void restart_recipe(struct Stepper *stepper);
 void InitializeRecipe(void);
 void update_state(struct Stepper *stepper, UINT8 input);
 
@@ -0,0 +1,193 @@
+#include "timeline.h"
+
+const struct TimelineEvent *timeline_events;
+const UINT16 *timeline_start;
+
+
+/*
+ * Header: runs a recipe on the interpreter up to its next event
+ *
+ * Params: cursor of the recipe, tick of its next command, returns the
+ *         tick of the event, and the event's position
+ * Return: void
+ */
+static void next_event(struct RecipeCursor *cursor, UINT32 *tick, UINT8 *position)
+{
+  for(; ; (*tick)++)
+  {
+    UINT8 running = cursor->recipe_number;
+
+    switch(RunRecipeSwitch(cursor, position))
+    {
+      case RECIPE_STEP_MOVE:
+        return;
+
+      case RECIPE_STEP_END:
+        *position = TIMELINE_END;
+        return;
+
+      case RECIPE_STEP_NONE:
+        if(running != cursor->recipe_number)
+        {
+          *position = TIMELINE_LOAD | cursor->recipe_number;
+          return;
+        }
+        break;
+    }
+  }
+}
+
+/*
+ * Header: Compiles one recipe into its timeline by running it on the
+ *         interpreter, so the timeline does exactly what the recipe would.
+ *         The recipe has to have passed VerifyRecipes and end.
+ *
+ * Params: recipe number, room for the events and how many fit
+ * Return: number of events, the END included, 0 if they do not fit or the
+ *         recipe cannot be compiled
+ */
+UINT16 CompileTimeline(UINT8 number, struct TimelineEvent *events, UINT16 size)
+{
+  struct RecipeCursor cursor;
+  UINT16 count = 0;
+  UINT32 tick;
+  UINT8 position;
+
+  if(!TimelineWanted(number))
+  {
+    return 0;
+  }
+
+  StartRecipe(&cursor, number);
+  for(tick = 0; ; tick++)
+  {
+    next_event(&cursor, &tick, &position);
+    if(size == count)
+    {
+      return 0;
+    }
+    events[count].tick = tick;
+    events[count].position = position;
+    count++;
+    if(TIMELINE_END == position)
+    {
+      return count;
+    }
+  }
+}
+
+/*
+ * Header: whether a recipe can have a timeline, it passed the verifier
+ *         and ends
+ *
+ * Params: recipe number
+ * Return: 1 if it can
+ */
+UINT8 TimelineWanted(UINT8 number)
+{
+  return number < number_of_recipes && RECIPE_OK == recipe_check[number] && RECIPE_FOREVER != recipe_ticks[number];
+}
+
+/*
+ * Header: Compiles the timeline of every recipe of the loaded image that
+ *         can have one and plays them from there. A recipe whose timeline
+ *         does not fit in what is left gets none, the others are not
+ *         affected.
+ *
+ * Params: room for the events and how many fit, room for MAX_RECIPES + 1
+ *         starts, both have to stay there while the recipes run
+ * Return: number of recipes whose timeline did not fit
+ */
+UINT8 CompileTimelines(struct TimelineEvent *events, UINT16 size, UINT16 *start)
+{
+  UINT16 used = 0;
+  UINT8 missing = 0;
+  UINT8 i;
+
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    start[i] = used;
+    if(TimelineWanted(i))
+    {
+      UINT16 count = CompileTimeline(i, &events[used], size - used);
+      if(0 == count)
+      {
+        missing++;
+      }
+      used += count;
+    }
+  }
+  start[number_of_recipes] = used;
+  timeline_events = events;
+  timeline_start = start;
+  return missing;
+}
+
+/*
+ * Header: Plays the loaded image from timelines compiled ahead of time,
+ *         such as the ones recipe_asm generates in flash. Each one is
+ *         checked against the recipe run on the interpreter, so stale
+ *         timelines are never played. A recipe recipe_asm had no room
+ *         for has an empty timeline and goes to ERROR.
+ *
+ * Params: events, starts and the number of recipes they were made for
+ * Return: 0 if they are the timelines of the loaded image, 1 if not
+ */
+UINT8 UseTimelines(const struct TimelineEvent *events, const UINT16 *start, UINT8 recipes)
+{
+  struct RecipeCursor cursor;
+  UINT32 tick;
+  UINT16 event;
+  UINT8 position;
+  UINT8 i;
+
+  if(number_of_recipes != recipes)
+  {
+    return 1;
+  }
+  for(i = 0; i < number_of_recipes; i++)
+  {
+    if(start[i] > start[i + 1] || (!TimelineWanted(i) && start[i] != start[i + 1]))
+    {
+      return 1;
+    }
+    if(start[i] == start[i + 1])
+    {
+      continue;
+    }
+
+    StartRecipe(&cursor, i);
+    event = start[i];
+    for(tick = 0; ; tick++)
+    {
+      next_event(&cursor, &tick, &position);
+      if(start[i + 1] == event || tick != events[event].tick || position != events[event].position)
+      {
+        return 1;
+      }
+      event++;
+      if(TIMELINE_END == position)
+      {
+        break;
+      }
+    }
+    if(start[i + 1] != event)
+    {
+      return 1;
+    }
+  }
+  timeline_events = events;
+  timeline_start = start;
+  return 0;
+}
+
+/*
+ * Header: whether a recipe of the loaded image has a timeline to play
+ *
+ * Params: recipe number
+ * Return: 1 if the recipe has a timeline
+ */
+UINT8 HasTimeline(UINT8 number)
+{
+  return number < number_of_recipes && timeline_start[number] != timeline_start[number + 1];
+}
@@ -0,0 +1,51 @@
+#ifndef _timeline_
+#define _timeline_
+
+#include "interpreter.h"
+
+// A recipe only reacts to pause and continue, so everything it does can be
+// worked out ahead of time. A timeline is a recipe run once on the
+// interpreter keeping only what the servo sees: the tick of each move,
+// counted from the start of the recipe while it is not paused, the tick of
+// each LOAD, so B restarts the recipe the interpreter would, and the tick
+// its END runs. Loops and waits are gone, playing a timeline back costs
+// the same per tick whatever the recipe looks like.
+//
+// Timelines only depend on the image, recipe_asm -c writes those of the
+// built in image into flash next to it (default_recipes.c) and the
+// firmware checks them with UseTimelines. CompileTimelines builds them
+// into RAM for an image loaded at run time.
+
+// position of the event that ends a timeline
+#define TIMELINE_END 0xFF
+
+// position of a LOAD event, or'ed with the recipe it loads
+#define TIMELINE_LOAD 0x80
+#define TIMELINE_IS_LOAD(position) (TIMELINE_END != (position) && 0 != ((position) & TIMELINE_LOAD))
+
+struct TimelineEvent
+{
+  UINT32 tick;
+  UINT8 position;
+};
+
+// events of every timeline of the loaded image one after the other,
+// recipe i's run from timeline_start[i] up to timeline_start[i + 1], none
+// for a recipe that was rejected, runs forever or did not fit
+extern const struct TimelineEvent *timeline_events;
+extern const UINT16 *timeline_start;
+
+#ifdef RECIPE_PLAYBACK
+// built in timelines, generated with default_recipe_image
+extern const struct TimelineEvent default_recipe_image_timeline_events[];
+extern const UINT16 default_recipe_image_timeline_start[];
+extern const UINT8 default_recipe_image_timeline_recipes;
+#endif
+
+UINT16 CompileTimeline(UINT8 number, struct TimelineEvent *events, UINT16 size);
+UINT8 CompileTimelines(struct TimelineEvent *events, UINT16 size, UINT16 *start);
+UINT8 UseTimelines(const struct TimelineEvent *events, const UINT16 *start, UINT8 recipes);
+UINT8 TimelineWanted(UINT8 number);
+UINT8 HasTimeline(UINT8 number);
+
+#endif
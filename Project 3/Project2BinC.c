@@ -11,6 +11,8 @@
 #include <signal.h>
 #include <sys/netmgr.h>
 
+#include "recipe.h"       /* Project 2, recipe images and their verifier */
+
 // IO port used here corresponds to a single register, which is
 // one byte long
 #define PORT_LENGTH 1
@@ -32,20 +34,18 @@
 #define LOW 0x00
 #define HIGH 0xFF
 
-#define STEPPER_POSITIONS 6
-
 // PWM channels to use for servo
 // 0 represents port A and 1 represents port B
 #define PWM_CHANNEL0 0
 #define PWM_CHANNEL1 1
 
-// Mnemonic defination
-#define END ((unsigned char) 0x00 << 5)
-#define MOV ((unsigned char) 0x01 << 5)
-#define WAIT ((unsigned char) 0x02 << 5)
-#define START_LOOP ((unsigned char) 0x04 << 5)
-#define END_LOOP ((unsigned char) 0x05 << 5)
-#define LOAD ((unsigned char) 0x06 << 5)
+// every command is followed by the servo thread's 100 ms sleep, a MOV also
+// sleeps 200 ms per position it moves and WAIT n sleeps n * 100 ms
+#define TICK_MS 100
+#define MOV_MS_PER_POSITION 200
+
+// duration of a recipe whose LOADs come back to it
+#define RECIPE_FOREVER_MS -1
 
 // constants to keep track of input validity
 #define INVALID_INPUTS 0
@@ -90,11 +90,11 @@ struct Stepper
 	// Current position of stepper
 	unsigned char position;
 
-	// Program counter
-	unsigned char PC;
+	// Program counter, offset of the next command in recipe_code
+	int PC;
 
-	// Loop start position
-	unsigned char LPS;
+	// Loop start position, offset in recipe_code
+	int LPS;
 
 	// Loop counter
 	unsigned char LPC;
@@ -114,7 +114,18 @@ struct timespec SERVO2DELAY1;
 struct Stepper stepper1,stepper2;
 
 int high_for_position[STEPPER_POSITIONS] = {100000,700000,1000000,1300000,1600000,2000000};
-unsigned char **recipe;
+
+// The recipes are loaded and verified by Project 2's recipe.c, the same
+// code the HCS12 runs (recipe_code, RecipeStart, recipe_check), built in
+// recipes come from its generated default_recipes.c. On top of that the
+// milliseconds from the start of each recipe until END runs, following
+// LOADs, when the servo starts at position 0 and when it starts wherever
+// takes longest.
+long recipe_ms[MAX_RECIPES];
+long recipe_worst_ms[MAX_RECIPES];
+
+// an image given on the command line is read in here once
+unsigned char recipe_file[RECIPE_MAX_CODE];
 
 // handles for port A, port B and control register
 uintptr_t ctrl_handle;
@@ -122,94 +133,193 @@ uintptr_t data_handle_A;
 uintptr_t data_handle_B;
 
 /*
- * Initializes the recipe table
+ * runs a verified recipe that ends on paper: how long a MOV sleeps depends
+ * on where the servo is, so the recipe, its loop passes and the recipes it
+ * LOADs are walked command by command from the given position
+ *
+ * Params: recipe number, position the servo starts at
+ * Return: milliseconds until END runs
+ */
+long recipe_duration(int number, int position)
+{
+	long ms = 0;
+	int loop_count = 0;
+	int loop_start = 0;
+	int pc = RecipeStart(number);
+
+	for(;;)
+	{
+		unsigned char opcode = recipe_code[pc] & OPCODE_MASK;
+		unsigned char parameter = recipe_code[pc] & PARAMETER_MASK;
+
+		switch(opcode)
+		{
+		case MOV:
+			ms += TICK_MS + MOV_MS_PER_POSITION * abs(parameter - position);
+			position = parameter;
+			pc++;
+			break;
+
+		case WAIT:
+			ms += TICK_MS + TICK_MS * parameter;
+			pc++;
+			break;
+
+		case START_LOOP:
+			ms += TICK_MS;
+			loop_count = parameter;
+			loop_start = ++pc;
+			break;
+
+		case END_LOOP:
+			ms += TICK_MS;
+			if(0 == loop_count)
+			{
+				pc++;
+			}
+			else
+			{
+				loop_count--;
+				pc = loop_start;
+			}
+			break;
+
+		case END:
+			return ms;
+
+		case LOAD:
+			ms += TICK_MS;
+			pc = RecipeStart(parameter);
+			break;
+		}
+	}
+}
+
+/*
+ * works out how long each recipe of the loaded image runs, the verifier
+ * already rejected the bad ones and found the ones that never end
+ * (recipe_ticks)
+ *
+ * Params: void
+ * Return: void
+ */
+void time_recipes(void)
+{
+	int i, position;
+
+	for(i = 0; i < number_of_recipes; i++)
+	{
+		recipe_ms[i] = RECIPE_FOREVER_MS;
+		recipe_worst_ms[i] = RECIPE_FOREVER_MS;
+		if(RECIPE_OK != recipe_check[i] || RECIPE_FOREVER == recipe_ticks[i])
+		{
+			continue;
+		}
+		recipe_ms[i] = recipe_duration(i, 0);
+		for(position = 0; position < STEPPER_POSITIONS; position++)
+		{
+			long ms = recipe_duration(i, position);
+			if(recipe_worst_ms[i] < ms)
+			{
+				recipe_worst_ms[i] = ms;
+			}
+		}
+	}
+}
+
+/*
+ * lists what the verifier found for each recipe and how long it runs, so
+ * the timing can be checked before any servo moves
  *
  * Params: void
  * Return: void
  */
+void report_recipes(void)
+{
+	static const char *checks[] =
+	{
+		"ok", "bad opcode", "MOV past the last position", "nested loop",
+		"END_LOOP without LOOP", "loop not closed", "no END", "LOAD of a missing recipe",
+		"LOADs a rejected recipe"
+	};
+	int i;
+
+	for(i = 0; i < number_of_recipes; i++)
+	{
+		printf("recipe %d: %s", i, checks[recipe_check[i]]);
+		if(RECIPE_OK != recipe_check[i])
+		{
+			printf("\n");
+		}
+		else if(RECIPE_FOREVER_MS == recipe_ms[i])
+		{
+			printf(", runs forever\n");
+		}
+		else
+		{
+			printf(", %ld ms from position 0, %ld ms at most\n", recipe_ms[i], recipe_worst_ms[i]);
+		}
+	}
+}
+
+/*
+ * Initializes the recipe table from an image file written by recipe_asm,
+ * or from the built in recipes without one
+ *
+ * Params: image file name or NULL
+ * Return: 0 if loaded, -1 if the file cannot be read or is malformed
+ */
 
-void InitializeRecipe()
+int InitializeRecipe(const char *path)
 {
-	recipe = malloc(sizeof(unsigned char *) * 9);
-
-
-	/* Verify default time delay */
-	recipe[0] = malloc(sizeof(unsigned char) * 4);
-	recipe[0][0] = MOV|0;
-	recipe[0][1] = MOV|5;
-	recipe[0][2] = MOV|0;
-	recipe[0][3] = END;
-
-	/* Verify default loop behavior */
-	recipe[1] = malloc(sizeof(unsigned char) * 7);
-	recipe[1][0] = MOV|3;
-	recipe[1][1] = START_LOOP|0;
-	recipe[1][2] = MOV|1;
-	recipe[1][3] = MOV|4;
-	recipe[1][4] = END_LOOP;
-	recipe[1][5] = MOV|0;
-	recipe[1][6] = END;
-
-	/* Verify wait 0 */
-	recipe[2] = malloc(sizeof(unsigned char) * 4);
-	recipe[2][0] = MOV|2;
-	recipe[2][1] = WAIT|0;
-	recipe[2][2] = MOV|3;
-	recipe[2][3] = END;
-
-	/* 9.3 second delay */
-	recipe[3] = malloc(sizeof(unsigned char) * 7);
-	recipe[3][0] = MOV|2;
-	recipe[3][1] = MOV|3;
-	recipe[3][2] = WAIT|31;
-	recipe[3][3] = WAIT|31;
-	recipe[3][4] = WAIT|31;
-	recipe[3][5] = MOV|4;
-	recipe[3][6] = END;
-
-	/* Every position */
-	recipe[4] = malloc(sizeof(unsigned char) * 12);
-	recipe[4][0] = MOV|0;
-	recipe[4][1] = WAIT|10;
-	recipe[4][2] = MOV|1;
-	recipe[4][3] = WAIT|10;
-	recipe[4][4] = MOV|2;
-	recipe[4][5] = WAIT|10;
-	recipe[4][6] = MOV|3;
-	recipe[4][7] = WAIT|10;
-	recipe[4][8] = MOV|4;
-	recipe[4][9] = WAIT|10;
-	recipe[4][10] = MOV|5;
-	recipe[4][11] = END;
-
-
-	/* Immediate end */
-	recipe[5] = malloc(sizeof(unsigned char) * 3);
-	recipe[5][0] = END;
-	recipe[5][1] = MOV|3;
-	recipe[5][2] = END;
-
-	/* Recipe command error */
-	recipe[6] = malloc(sizeof(unsigned char) * 4);
-	recipe[6][0] = MOV|0;
-	recipe[6][1] = MOV|5;
-	recipe[6][2] = MOV|6;
-	recipe[6][3] = END;
-
-	/* Nested Loop Error */
-	recipe[7] = malloc(sizeof(unsigned char) * 2);
-	recipe[7][0] = START_LOOP|1;
-	recipe[7][1] = START_LOOP|1;
-	recipe[7][2] = END;
-
-	/* Recipe with new OPcode */
-	recipe[8] = malloc(sizeof(unsigned char) * 3);
-	recipe[8][0] = MOV|5;
-	recipe[8][1] = WAIT|2;
-	recipe[8][2] = LOAD|4;
+	const unsigned char *image = default_recipe_image;
+	int length = default_recipe_image_length;
+
+	if(NULL != path)
+	{
+		FILE *file = fopen(path, "rb");
+		if(NULL == file)
+		{
+			return -1;
+		}
+		length = fread(recipe_file, 1, sizeof(recipe_file), file);
+		fclose(file);
+		image = recipe_file;
+	}
 
+	if(IMAGE_OK != LoadRecipeImage(image, length))
+	{
+		return -1;
+	}
+	time_recipes();
+	return 0;
 }
 
+/*
+ * starts the servo's recipe from the top, or goes to ERROR if the recipe
+ * was rejected when it was loaded
+ *
+ * Params: stepper motor 1 or 2
+ * Return: void
+ */
+void restart_recipe(struct Stepper *stepper)
+{
+	stepper->PC = RecipeStart(stepper->recipe_number);
+	stepper->LPC = 0;
+
+	if(number_of_recipes <= stepper->recipe_number || RECIPE_OK != recipe_check[stepper->recipe_number])
+	{
+		stepper->error_encountered = number_of_recipes > stepper->recipe_number && RECIPE_NESTED_LOOP == recipe_check[stepper->recipe_number] ? NESTED_LOOP_ERROR : RECIPE_COMMAND_ERROR;
+		stepper->state = ERROR;
+	}
+	else
+	{
+		stepper->error_encountered = NO_ERROR;
+		stepper->state = RUN;
+	}
+}
+
+
 /*
  * Initialization of stepper struct
  *
@@ -220,13 +330,11 @@ void InitializeRecipe()
 void set_stepper(struct Stepper *stepper, unsigned char pwm, unsigned char current_recipe)
 {
 	stepper->pwm_channel = pwm;
-	stepper->state = RUN;
 	stepper->recipe_number = current_recipe;
-	stepper->PC = 0;
 	stepper->position = 0;
+	restart_recipe(stepper);
 }
 
-
 /*
  * moves the motor by changing pulse width
  *
@@ -259,16 +367,18 @@ void move(struct Stepper *stepper,unsigned char position)
 }
 
 /*
- * runs the next instruction
+ * runs the next instruction. Recipes were verified when they were loaded
+ * (VerifyRecipes) and a rejected one is never started, so nothing is
+ * checked here.
  *
  * Params: stepper motor 1 or 2
  * Return: void
  */
 void run_next_command(struct Stepper *stepper)
 {
-	unsigned char command = recipe[stepper->recipe_number][stepper->PC];
-	unsigned char opcode = command & 0xE0;
-	unsigned char parameter = command & 0x1F;
+	unsigned char command = recipe_code[stepper->PC];
+	unsigned char opcode = command & OPCODE_MASK;
+	unsigned char parameter = command & PARAMETER_MASK;
 	struct timespec temp;
 	int diff = 0;
 
@@ -277,31 +387,21 @@ void run_next_command(struct Stepper *stepper)
 	switch(opcode)
 	{
 	case MOV:
-		//check parameter validity
-		if(STEPPER_POSITIONS <= parameter )
+		// scale the wait depending upon difference in current position and next position
+		//printf("Moving to %d \r\n",parameter);
+		if(parameter > stepper->position)
 		{
-			//printf("Recipe command error encountered");
-			stepper->error_encountered = RECIPE_COMMAND_ERROR;
-			stepper->state = ERROR;
+			diff = parameter - stepper->position;
 		}
 		else
 		{
-            // scale the wait depending upon difference in current position and next position
-			//printf("Moving to %d \r\n",parameter);
-			if(parameter > stepper->position)
-			{
-				diff = parameter - stepper->position;
-			}
-			else
-			{
-				diff = stepper->position - parameter;
-			}
-			move(stepper,parameter);
-			temp.tv_sec = (diff * 200)/1000;
-			temp.tv_nsec = ((diff * 200)%1000) * 1000000;
-			clock_nanosleep(CLOCK_REALTIME,0,&temp,NULL);
-			stepper->PC++;
+			diff = stepper->position - parameter;
 		}
+		move(stepper,parameter);
+		temp.tv_sec = (diff * 200)/1000;
+		temp.tv_nsec = ((diff * 200)%1000) * 1000000;
+		clock_nanosleep(CLOCK_REALTIME,0,&temp,NULL);
+		stepper->PC++;
 		break;
 
 	case WAIT:
@@ -313,18 +413,10 @@ void run_next_command(struct Stepper *stepper)
 		break;
 
 	case START_LOOP:
-		if(0 != stepper->LPC)
-		{
-			stepper->error_encountered = NESTED_LOOP_ERROR;
-			stepper->state = ERROR;
-		}
-		else
-		{
-			//printf("Loop started for %d times \r\n",parameter);
-			stepper->LPC = parameter;
-			stepper->LPS = stepper->PC + 1;
-			stepper->PC++;
-		}
+		//printf("Loop started for %d times \r\n",parameter);
+		stepper->LPC = parameter;
+		stepper->LPS = stepper->PC + 1;
+		stepper->PC++;
 		break;
 
 	case END_LOOP:
@@ -347,23 +439,9 @@ void run_next_command(struct Stepper *stepper)
 		break;
 
 	case LOAD:
-		if(NO_OF_RECIPES >= parameter)
-		{
-			stepper->PC = 0;
-			stepper->recipe_number = parameter;
-			stepper->state = RUN;
-		}
-		else
-		{
-			stepper->error_encountered = RECIPE_COMMAND_ERROR;
-			stepper->state = ERROR;
-		}
-		break;
-
-
-	default:
-		stepper->error_encountered = RECIPE_COMMAND_ERROR;
-		stepper->state = ERROR;
+		stepper->PC = RecipeStart(parameter);
+		stepper->recipe_number = parameter;
+		stepper->state = RUN;
 		break;
 	}
 }
@@ -490,8 +568,7 @@ void update_state(struct Stepper *stepper, unsigned char input)
 
 			case 'B':
 			case 'b':
-				stepper->PC = 0;
-				stepper->state = RUN;
+				restart_recipe(stepper);
 				break;
 			}
 			break;
@@ -519,8 +596,7 @@ void update_state(struct Stepper *stepper, unsigned char input)
 
 				case 'B':
 				case 'b':
-					stepper->PC = 0;
-					stepper->state = RUN;
+					restart_recipe(stepper);
 					break;
 				}
 				break;
@@ -540,8 +616,7 @@ void update_state(struct Stepper *stepper, unsigned char input)
 
 					case 'B':
 					case 'b':
-						stepper->PC = 0;
-						stepper->state = RUN;
+						restart_recipe(stepper);
 						break;
 					}
 					break;
@@ -561,8 +636,7 @@ void update_state(struct Stepper *stepper, unsigned char input)
 
 						case 'B':
 						case 'b':
-							stepper->PC = 0;
-							stepper->state = RUN;
+							restart_recipe(stepper);
 							break;
 						}
 						break;
@@ -586,8 +660,6 @@ void setup()
 	set_stepper(&stepper1,PWM_CHANNEL_STEPPER1,STEPPER1_RECIPE);
 	set_stepper(&stepper2,PWM_CHANNEL_STEPPER2,STEPPER2_RECIPE);
 
-    // allocate memoery and intialize recipe
-	InitializeRecipe();
 }
 
 // This thread controls PWM for 2nd servo
@@ -708,7 +780,9 @@ void *servo2(void* empty)
 	}
 }
 
-int main( )
+// usage: Project2BinC [image], image is a recipe image written by recipe_asm,
+// the built in recipes are used without one
+int main(int argc, char *argv[])
 {
 	int privity_err;
 	unsigned char userInput1,userInput2;
@@ -725,6 +799,14 @@ int main( )
 		return -1;
 	}
 
+	// load the recipes before any servo can run one
+	if(-1 == InitializeRecipe(argc > 1 ? argv[1] : NULL))
+	{
+		fprintf( stderr, "can't load recipe image %s\n", argc > 1 ? argv[1] : "built in recipes" );
+		return -1;
+	}
+	report_recipes();
+
 	// set port and initialize required variable values
 	setup();
 
@@ -1,334 +1,798 @@
-#include <queue>
 #include <iostream>
+#include <atomic>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
 #include <time.h>
 
-#define BANKHOURS 7
-#define BANKHOURS_SIMULATION_TIME BANKHOURS * 60 * 0.1
-#define SCALE_TO_NANOSECONDS 100000000
-
-#define NUMBER_OF_TELLERS 3
-
-//customer struct definition
+#include "bank.h"
+#include "checkpoint.h"
+#include "coro.h"
+#include "des.h"
+#include "live.h"
+#include "mpmc_queue.h"
+#include "region.h"
+#include "replication.h"
+#include "series.h"
+#include "sim_time.h"
+#include "trace.h"
+
+// what one teller is doing, only written by that teller and read by the
+// sampler for the live metrics
+typedef struct
+{
+	alignas(CACHE_LINE_SIZE) std::atomic<int> state;	// a live_teller_state
+	std::atomic<unsigned int> served;
+	std::atomic<int64_t> waited;			// queue wait of its customers, ticks
+	std::atomic<int64_t> transacting;		// time spent with them, ticks
+} teller_activity;
+
+// Everything the threads of one branch share, nothing is global so one
+// process can run several branches at once
 typedef struct
 {
-	struct timespec qPushTime;		// The arrival time of the customer
-	struct timespec qPopTime;		// The time it takes the customer to leave the queue'
-	unsigned int serviceTime;
-} customer;
+	// Queue to store customers, lock-free so tellers and the customer
+	// generator never serialise on a mutex
+	mpmc_queue<customer, CUSTOMER_QUEUE_CAPACITY> customers;
+
+	// one token per customer pushed and one per teller when the bank
+	// closes, tellers block on it instead of polling the queue
+	sem_t customers_available;
+
+	bool BankClosed;
+
+	// what the tellers are doing, for the time series sampler
+	std::atomic<int> busy_tellers;
+	std::atomic<int> tellers_on_break;
 
-// Queue to store customers
-pthread_mutex_t queue_semaphore, previous_queue_semaphore;
-std::queue<customer> customers, previousCustomers;
+	teller_activity *activity;				// one per teller
+	std::atomic<unsigned int> arrived;
 
-double teller_maximum_time_waiting = 0;
-double teller_average_time_waiting = 0;
+	// the sampler keeps going until every teller went home
+	std::atomic<bool> sampling;
+	time_series *series;
+	live_block *live;
 
-bool BankClosed = false;
+	// real clock reading (CLOCK_REALTIME, ns) when the bank opened
+	int64_t opening_time;
 
-//creates a customer
-customer create_customer(struct timespec currentTime)
+	// how arrival gaps and transaction times are drawn
+	bank_params params;
+} branch;
+
+// what each teller thread owns, nothing in it is shared
+typedef struct
+{
+	branch *bank;
+	int teller;
+	teller_stats stats;
+	rng_state random;
+	stats_accumulator wakeup_lateness;
+	trace_buffer trace;
+} teller_context;
+
+// simulated time since the bank opened
+sim_ticks simulated_now(const branch *bank)
 {
-	customer temporaryCustomer;
-	temporaryCustomer.qPushTime = currentTime;
-	temporaryCustomer.serviceTime = (rand()%331) + 30;
-	return temporaryCustomer;
+	return real_ns_to_simulated(real_clock_ns() - bank->opening_time);
 }
 
-//Converts simulated minutes to equivalent real timespec
-timespec simulated_minutes_to_time(unsigned int minutes)
+// real clock deadline for a simulated time, for sem_timedwait
+timespec simulated_to_deadline(const branch *bank, sim_ticks time)
 {
-	struct timespec time;
-	time.tv_sec = minutes/10;
-	time.tv_nsec = minutes%10 * SCALE_TO_NANOSECONDS;
-	return time;
+	return ns_to_timespec(bank->opening_time + simulated_to_real_ns(time));
 }
 
-//Converts simulated minutes to equivalent real timespec
-timespec simulated_seconds_to_time(unsigned int seconds)
+// records how far past its deadline (simulated time) a thread woke up
+void record_lateness(const branch *bank, sim_ticks deadline, stats_accumulator *lateness)
 {
-	struct timespec time;
-	time.tv_sec = seconds/600;
-	time.tv_nsec = ((seconds/60)%10) * SCALE_TO_NANOSECONDS;
-	return time;
+	int64_t late = real_clock_ns() - (bank->opening_time + simulated_to_real_ns(deadline));
+	stats_add(lateness, late / 1000.0);
 }
 
-// calculates difference between two timespec in terms of seconds
-long time_difference_to_simulated_seconds(struct timespec time1,struct timespec time2)
+// Sleeps until an absolute simulated time. Unlike a relative sleep,
+// time spent waking up and doing work does not push later deadlines back.
+void sleep_until(const branch *bank, sim_ticks deadline, stats_accumulator *lateness)
 {
-	long time;
-	time = (time1.tv_sec - time2.tv_sec) * 600;
-	if(time1.tv_nsec > time2.tv_nsec )
+	struct timespec deadline_time = simulated_to_deadline(bank, deadline);
+	while(EINTR == clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &deadline_time, NULL))
 	{
-		time += ((time1.tv_nsec - time2.tv_nsec) / SCALE_TO_NANOSECONDS) * 60;
 	}
-	else
+	record_lateness(bank, deadline, lateness);
+}
+
+//function for teller thread, gets its own teller_context
+void *eachTeller(void *argument)
+{
+	teller_context *context = (teller_context *)argument;
+	branch *bank = context->bank;
+	teller_stats *stats = &context->stats;
+	rng_state *random = &context->random;
+	stats_accumulator *lateness = &context->wakeup_lateness;
+	trace_buffer *trace = &context->trace;
+	teller_activity *activity = &bank->activity[context->teller];
+	sim_ticks idle_pending = 0;
+	sim_ticks waiting_since;
+	sim_ticks lastbreak;
+	sim_ticks current_time;
+
+	//decide first break
+	sim_ticks breakAfter = MINUTES_TO_TICKS(rng_between(random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+	lastbreak = simulated_now(bank);
+	waiting_since = lastbreak;
+	trace_record(trace, TRACE_IDLE, context->teller, waiting_since, 0);
+
+	while(1)
 	{
-		time -= ((time2.tv_nsec - time1.tv_nsec) / SCALE_TO_NANOSECONDS) * 60;
+		// sleep until a customer is announced, the bank closes or it is
+		// time for a break, whichever comes first
+		struct timespec break_time = simulated_to_deadline(bank, lastbreak + breakAfter);
+		int wait_result;
+		do
+		{
+			wait_result = sem_timedwait(&bank->customers_available, &break_time);
+		} while(-1 == wait_result && EINTR == errno);
+
+		current_time = simulated_now(bank);
+
+		if(-1 == wait_result)
+		{
+			//timed out, time for break, it starts when it was due
+			record_lateness(bank, lastbreak + breakAfter, lateness);
+			//std::cout << "It's been " << ticks_to_seconds(current_time - lastbreak) << "since last break, taking break" << std::endl;
+			lastbreak += breakAfter;
+			idle_pending += lastbreak - waiting_since;
+			breakAfter = MINUTES_TO_TICKS(rng_between(random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+			waiting_since = lastbreak + MINUTES_TO_TICKS(rng_between(random, MIN_BREAK_MINUTES, MAX_BREAK_MINUTES));
+			trace_record(trace, TRACE_BREAK_START, context->teller, lastbreak, trace_ms(waiting_since - lastbreak));
+			bank->tellers_on_break.fetch_add(1, std::memory_order_relaxed);
+			activity->state.store(LIVE_ON_BREAK, std::memory_order_relaxed);
+			sleep_until(bank, waiting_since, lateness);
+			activity->state.store(LIVE_IDLE, std::memory_order_relaxed);
+			bank->tellers_on_break.fetch_sub(1, std::memory_order_relaxed);
+			trace_record(trace, TRACE_BREAK_END, context->teller, waiting_since, 0);
+			trace_record(trace, TRACE_IDLE, context->teller, waiting_since, 0);
+			continue;
+		}
+
+		customer current_customer;
+
+		//get next customer if there is any
+		bool hasCustomer = bank->customers.pop(current_customer);
+
+		//if there is customer, service customer
+		if(true == hasCustomer)
+		{
+			// teller waited from waiting_since until woken up for this customer
+			sim_ticks wait_time = idle_pending + current_time - waiting_since;
+			record_teller_wait(stats, wait_time);
+			//std::cout << "teller was waiting from " << waiting_since << " to " << current_time << " " << ticks_to_seconds(wait_time) << std::endl;
+			idle_pending = 0;
+
+			current_customer.qPopTime = current_time;
+			record_queue_wait(stats, current_customer.qPopTime - current_customer.qPushTime);
+			trace_record(trace, TRACE_DEQUEUE, context->teller, current_time, trace_ms(current_customer.qPopTime - current_customer.qPushTime));
+			trace_record(trace, TRACE_SERVICE_START, context->teller, current_time, trace_ms(current_customer.serviceTime));
+
+			// transaction ends at a fixed simulated time, however late the
+			// teller woke up for the customer
+			current_time += current_customer.serviceTime;
+			bank->busy_tellers.fetch_add(1, std::memory_order_relaxed);
+			activity->state.store(LIVE_BUSY, std::memory_order_relaxed);
+			sleep_until(bank, current_time, lateness);
+			activity->state.store(LIVE_IDLE, std::memory_order_relaxed);
+			bank->busy_tellers.fetch_sub(1, std::memory_order_relaxed);
+
+			// only this thread writes them, the sampler just reads
+			activity->served.store(activity->served.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			activity->waited.store(activity->waited.load(std::memory_order_relaxed) + current_customer.qPopTime - current_customer.qPushTime, std::memory_order_relaxed);
+			activity->transacting.store(activity->transacting.load(std::memory_order_relaxed) + current_customer.serviceTime, std::memory_order_relaxed);
+
+			record_transaction_time(stats, current_customer.serviceTime);
+			trace_record(trace, TRACE_SERVICE_END, context->teller, current_time, 0);
+
+			// a break that came due while serving starts right after the customer
+			if(current_time >= lastbreak + breakAfter)
+			{
+				breakAfter = MINUTES_TO_TICKS(rng_between(random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+				lastbreak = current_time;
+				current_time += MINUTES_TO_TICKS(rng_between(random, MIN_BREAK_MINUTES, MAX_BREAK_MINUTES));
+				trace_record(trace, TRACE_BREAK_START, context->teller, lastbreak, trace_ms(current_time - lastbreak));
+				bank->tellers_on_break.fetch_add(1, std::memory_order_relaxed);
+				activity->state.store(LIVE_ON_BREAK, std::memory_order_relaxed);
+				sleep_until(bank, current_time, lateness);
+				activity->state.store(LIVE_IDLE, std::memory_order_relaxed);
+				bank->tellers_on_break.fetch_sub(1, std::memory_order_relaxed);
+				trace_record(trace, TRACE_BREAK_END, context->teller, current_time, 0);
+			}
+			waiting_since = current_time;
+			trace_record(trace, TRACE_IDLE, context->teller, waiting_since, 0);
+		}
+		else if(true == bank->BankClosed)
+		{
+			//no customer and bank is closed, go home
+			activity->state.store(LIVE_GONE, std::memory_order_relaxed);
+			trace_flush(trace);
+			void* retValue = stats;
+			pthread_exit(retValue);
+		}
 	}
-	return time;
 }
 
-//compares two timespec
-bool isgreater(struct timespec time1,struct timespec time2)
+// what the branch is doing right now, from the atomics the threads keep
+static void collect_live_metrics(const branch *bank, sim_ticks now, live_metrics *metrics)
 {
-	if(time1.tv_sec > time2.tv_sec)
+	int64_t waited = 0;
+	int64_t transacting = 0;
+
+	memset(metrics, 0, sizeof(*metrics));
+	metrics->now = now;
+	metrics->tellers = bank->params.tellers;
+	metrics->queue_depth = bank->customers.size();
+	metrics->arrived = bank->arrived.load(std::memory_order_relaxed);
+	metrics->busy_tellers = bank->busy_tellers.load(std::memory_order_relaxed);
+	metrics->tellers_on_break = bank->tellers_on_break.load(std::memory_order_relaxed);
+	for(int i=0;i<bank->params.tellers;i++)
 	{
-		return true;
+		unsigned int served = bank->activity[i].served.load(std::memory_order_relaxed);
+		metrics->served += served;
+		waited += bank->activity[i].waited.load(std::memory_order_relaxed);
+		transacting += bank->activity[i].transacting.load(std::memory_order_relaxed);
+		if(i < LIVE_MAX_TELLERS)
+		{
+			metrics->teller_state[i] = bank->activity[i].state.load(std::memory_order_relaxed);
+			metrics->teller_served[i] = served;
+		}
 	}
-	else if(time1.tv_sec < time2.tv_sec)
+	if(metrics->served > 0)
 	{
-		return false;
+		metrics->average_wait = ticks_to_seconds(waited) / metrics->served;
+		metrics->average_transaction_time = ticks_to_seconds(transacting) / metrics->served;
 	}
-	else{
-		if(time1.tv_nsec > time2.tv_nsec)
+}
+
+// samples the queue and the tellers every simulated minute until every
+// teller went home, into the time series and/or the live metrics block.
+// It only reads atomics, so no teller ever waits for it.
+void *sampler(void *argument)
+{
+	branch *bank = (branch *)argument;
+	stats_accumulator lateness;
+	live_metrics metrics;
+	sim_ticks next_sample;
+	stats_init(&lateness);
+
+	for(next_sample=0;bank->sampling.load();next_sample+=SERIES_INTERVAL)
+	{
+		sleep_until(bank, next_sample, &lateness);
+		if(NULL != bank->series)
 		{
-			return true;
+			series_add(bank->series, bank->customers.size(), bank->busy_tellers.load(std::memory_order_relaxed), bank->tellers_on_break.load(std::memory_order_relaxed));
 		}
-		else
+		if(NULL != bank->live)
 		{
-			return false;
+			collect_live_metrics(bank, next_sample, &metrics);
+			live_publish(bank->live, &metrics);
 		}
 	}
-}
 
-// custom C function that call nanosleep and accepts simulated time
-void my_sleep_seconds(int seconds)
-{
-	struct timespec timesleep,rem;
-	timesleep = simulated_seconds_to_time(seconds);
-	nanosleep(&timesleep,&rem);
+	if(NULL != bank->live)
+	{
+		collect_live_metrics(bank, simulated_now(bank), &metrics);
+		metrics.closed = 1;
+		live_publish(bank->live, &metrics);
+	}
+	return NULL;
 }
 
-//function for teller thread
-void *eachTeller(void*)
+// simulation of bank and generating customers, paced by the real clock,
+// trace, series and live are NULL unless events are traced / the day is
+// sampled / live metrics are published
+bank_report run_wall_clock_bank(const bank_params *model, unsigned int seed, trace_file *trace, time_series *series, live_block *live)
 {
-	bool iswaiting = false;
-	double total_time_waiting = 0;
-	double max_time_waiting = 0;
-	unsigned int customers_serviced = 0;
-	timespec waiting_since;
-	timespec lastbreak;
 
-	//decide first break
-	long breakAfter = (rand() % 31) + 30;
-	clock_gettime(CLOCK_REALTIME,&lastbreak);
+	sim_ticks next_arrival;
+	sim_ticks closing_time;
+	unsigned int total_customers = 0;
+	stats_accumulator lateness;
+
+	rng_state random;
+
+	branch *bank = new branch;
+	bank->params = *model;
+	bank->BankClosed = false;
+	bank->series = series;
+	bank->live = live;
+	bank->activity = new teller_activity[bank->params.tellers];
+	bank->arrived.store(0);
+	pthread_t *threads = new pthread_t[bank->params.tellers];
+	void **results = new void *[bank->params.tellers];
+	teller_context *tellers = new teller_context[bank->params.tellers];
+	teller_stats *stats = new teller_stats[bank->params.tellers];
+	trace_buffer *arrivals = new trace_buffer;
+	trace_buffer_init(arrivals, trace);
+	rng_seed(&random, seed);
+
+	stats_init(&lateness);
+	bank->opening_time = real_clock_ns();
+	next_arrival = 0;
 
-	while(1)
+	// decide closing time
+	closing_time = BANKHOURS * TICKS_PER_HOUR;
+
+	//std::cout << "Started" << std::endl;
+
+	sem_init(&bank->customers_available, 0, 0);
+
+	pthread_t sampler_thread;
+	bank->busy_tellers.store(0);
+	bank->tellers_on_break.store(0);
+	bank->sampling.store(true);
+	if(NULL != series || NULL != live)
 	{
-		struct timespec current_time;
-		clock_gettime(CLOCK_REALTIME,&current_time);
+		pthread_create(&sampler_thread, NULL, &sampler, bank);
+	}
 
-		//check if time for break
-		if(time_difference_to_simulated_seconds(current_time,lastbreak) > breakAfter * 60)
-		{
-			//std::cout << "It's been " << time_difference_to_simulated_seconds(current_time,lastbreak) << "since last break, taking break" << std::endl;
-			breakAfter = (rand() % 31) + 30;
-			lastbreak = current_time;
-			my_sleep_seconds(rand() % 4 + 1);
-		}
+	// create a thread for each teller
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		bank->activity[i].state.store(LIVE_IDLE);
+		bank->activity[i].served.store(0);
+		bank->activity[i].waited.store(0);
+		bank->activity[i].transacting.store(0);
+		tellers[i].bank = bank;
+		tellers[i].teller = i;
+		teller_stats_init(&tellers[i].stats);
+		trace_buffer_init(&tellers[i].trace, trace);
+		stats_init(&tellers[i].wakeup_lateness);
+		rng_seed(&tellers[i].random, replication_seed(seed, i));
+		pthread_create(&threads[i], NULL, &eachTeller, &tellers[i]);
+	}
 
-		customer current_customer;
-		bool hasCustomer;
+	// create new customers till bank is open, every arrival is scheduled
+	// from the previous one so oversleeping does not lose customers
+	while(closing_time > next_arrival)
+	{
+		//sleep till it's time to create next customer
+		sleep_until(bank, next_arrival, &lateness);
 
-		//get next customer if there is any
-		pthread_mutex_lock(&queue_semaphore);
-		if(customers.empty())
+		//create customer add in queue
+		customer new_customer = create_customer(&bank->params, next_arrival, &random);
+		trace_record(arrivals, TRACE_ARRIVE, -1, next_arrival, total_customers);
+
+		//put customer in queue
+		if(bank->customers.push(new_customer))
 		{
-			hasCustomer = false;
+			sem_post(&bank->customers_available);
 		}
 		else
 		{
-			current_customer = customers.front();
-			customers.pop();
-			hasCustomer = true;
+			std::cerr << "customer queue is full" << std::endl;
 		}
-		pthread_mutex_unlock(&queue_semaphore);
 
-		//if there is customer, service customer
-		if(true == hasCustomer)
+		next_arrival += sample_arrival_gap(&random, &bank->params);
+
+		total_customers++;
+		bank->arrived.store(total_customers, std::memory_order_relaxed);
+	}
+	//std::cout << "Ended" << total_customers << std::endl;
+
+	//bank is closed, wake every teller so idle ones can go home
+	bank->BankClosed = true;
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		sem_post(&bank->customers_available);
+	}
+
+	//wait till/check if all threads have finished execution
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		pthread_join(threads[i],&results[i]);
+	}
+
+	bank->sampling.store(false);
+	if(NULL != series || NULL != live)
+	{
+		pthread_join(sampler_thread, NULL);
+	}
+
+	// destroy
+	sem_destroy(&bank->customers_available);
+	trace_flush(arrivals);
+
+	// every teller kept its own statistics, merge them
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		stats[i] = tellers[i].stats;
+	}
+	bank_report report = build_report(stats, bank->params.tellers, total_customers, bank->customers.max_size());
+
+	report.wakeup_lateness = lateness;
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		stats_merge(&report.wakeup_lateness, &tellers[i].wakeup_lateness);
+	}
+
+	delete[] threads;
+	delete[] results;
+	delete[] tellers;
+	delete[] stats;
+	delete arrivals;
+	delete[] bank->activity;
+	delete bank;
+	return report;
+}
+
+static void print_usage(const char *program)
+{
+	std::cerr << "usage: " << program << " [-v | -c tellers] [-n tellers] [-x ms] [-s seed] [-a dist] [-t dist] [-q discipline] [-p routing] [-T file] [-m file] [-L name] [-k file | -R file] [-r replications [-w width] [-j threads]] [-b branches [-j threads]]" << std::endl;
+}
+
+// usage: Project4 [-v | -c tellers] [-n tellers] [-x ms] [-s seed] [-a dist] [-t dist] [-q discipline] [-p routing] [-T file] [-m file] [-L name] [-k file | -R file] [-r replications [-w width] [-j threads]] [-b branches [-j threads]]
+//   -v  run in virtual time (discrete event simulation) instead of
+//       pacing the day with the real clock
+//   -c  run in virtual time with this many coroutine tellers on one
+//       thread instead of the usual three
+//   -n  number of tellers for the other modes, 3 by default
+//   -x  real milliseconds per simulated minute when pacing with the real
+//       clock, 100 by default
+//   -s  seed for the random number generators
+//   -a  distribution of the time between customers
+//   -t  distribution of the transaction times, dist is one of uniform
+//       (default), exponential or lognormal
+//   -q  order in which waiting customers are served in virtual time:
+//       fifo (default), sjf (shortest transaction first) or priority
+//       (three customer classes), compare runs -r days (1000 by
+//       default) under each and prints their customer wait as CSV
+//   -p  single (default) line, or a line per teller in the discrete event
+//       simulation: jsq (join the shortest line) or p2c (shorter of two
+//       random lines), idle tellers take customers from the longest
+//       line. compare prints single against both like -q compare
+//   -T  record every arrival, dequeue, service, break and idle teller in a
+//       binary trace file (wall clock and -v), see trace_decode.cc
+//   -m  sample the queue depth, busy tellers and tellers on break every
+//       simulated minute into a columnar file (wall clock and -v), see
+//       series_csv.cc
+//   -L  publish live metrics of the wall clock simulation every simulated
+//       minute in this POSIX shared memory object (e.g. /bank_live), see
+//       monitor.cc
+//   -k  with -v, write a checkpoint of the whole simulation to the file
+//       every simulated hour
+//   -R  resume the -v simulation from a checkpoint, the model and seed
+//       come from the checkpoint
+//   -r  simulate up to this many independent days in virtual time and
+//       report each metric with a 95% confidence interval
+//   -w  stop early once every interval is within this fraction of its
+//       mean (e.g. 0.02 for +/- 2%)
+//   -b  simulate this many branches of a region in virtual time on the
+//       same day, each with its own seed, and report the region as a whole
+//   -j  worker threads for -r and -b, defaults to every core
+int main(int argc, char *argv[]) {
+
+	bool virtual_time = false;
+	bool compare_queues = false;
+	bool compare_lines = false;
+	unsigned int coroutine_tellers = 0;
+	const char *trace_path = NULL;
+	const char *series_path = NULL;
+	const char *live_name = NULL;
+	const char *checkpoint_path = NULL;
+	const char *resume_path = NULL;
+	unsigned int seed = 1;
+	bank_params model;
+	replication_params replications;
+	unsigned int branches = 0;
+	int option;
+
+	default_bank_params(&model);
+	replications.max_replications = 0;
+	replications.threads = 0;
+	replications.target_relative_width = 0;
+
+	while((option = getopt(argc, argv, "vc:n:x:s:a:t:q:p:T:m:L:k:R:r:w:j:b:")) != -1)
+	{
+		switch(option)
 		{
-			//check if teller was waiting, if yes, count and save wait time
-			if(true == iswaiting)
+		case 'v':
+			virtual_time = true;
+			break;
+
+		case 'c':
+			coroutine_tellers = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'n':
+			model.tellers = atoi(optarg);
+			if(model.tellers < 1)
 			{
-				long wait_time = time_difference_to_simulated_seconds(current_time,waiting_since);
-				total_time_waiting += wait_time;
-				if(wait_time > max_time_waiting)
-				{
-					max_time_waiting = wait_time;
-				}
-				//std::cout << "teller was waiting from " << waiting_since.tv_sec <<"  " <<waiting_since.tv_nsec << "  " << current_time.tv_sec  <<"  " << current_time.tv_nsec << "  "<< wait_time << std::endl;
-				iswaiting = false;
+				std::cerr << "need at least one teller" << std::endl;
+				return EXIT_FAILURE;
 			}
-			current_customer.qPopTime = current_time;
-			//
-			//clock_gettime(CLOCK_REALTIME,&current_customer.qPopTime);
+			break;
 
-			my_sleep_seconds(current_customer.serviceTime);
+		case 'x':
+		{
+			// at least a real nanosecond per simulated minute, the time
+			// conversions divide by it
+			char *end;
+			double real_ns = strtod(optarg, &end) * 1000000;
+			if(end == optarg || '\0' != *end || !(real_ns >= 1 && real_ns < 9e18))
+			{
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			set_time_scale((int64_t)real_ns);
+			break;
+		}
 
-			// put serviced customer info in another queue
-			pthread_mutex_lock(&previous_queue_semaphore);
-			previousCustomers.push(current_customer);
-			pthread_mutex_unlock(&previous_queue_semaphore);
+		case 's':
+			seed = strtoul(optarg, NULL, 10);
+			break;
 
-			customers_serviced++;
-		}
-		else
-		{
-			//no customer,
-			if(true == BankClosed)
+		case 'a':
+			if(false == parse_distribution(optarg, &model.arrival_distribution))
 			{
-				//prepare exit
-				if(max_time_waiting > teller_maximum_time_waiting)
-				{
-					teller_maximum_time_waiting = max_time_waiting;
-				}
-				teller_average_time_waiting += (total_time_waiting/customers_serviced)/NUMBER_OF_TELLERS;
-				void* retValue = 0;
-				pthread_exit(retValue);
+				std::cerr << "unknown distribution " << optarg << std::endl;
+				return EXIT_FAILURE;
 			}
-			else
+			break;
+
+		case 't':
+			if(false == parse_distribution(optarg, &model.service_distribution))
 			{
-				//wait if bank is not closed
-				if(false == iswaiting)
-				{
-					waiting_since = current_time;
-					iswaiting = true;
-				}
+				std::cerr << "unknown distribution " << optarg << std::endl;
+				return EXIT_FAILURE;
 			}
-		}
-	}
-}
+			break;
 
-// simulation of bank and generating customers
-int main(int argc, char *argv[]) {
+		case 'q':
+			if(0 == strcmp(optarg, "compare"))
+			{
+				compare_queues = true;
+			}
+			else if(false == parse_discipline(optarg, &model.discipline))
+			{
+				std::cerr << "unknown queue discipline " << optarg << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
 
-	struct timespec current_time;
-	struct timespec closing_time;
-	struct timespec rem;
-	struct timespec timesleep;
-	unsigned int wait_minute;
-	unsigned int total_customers = 0;
-	unsigned int max_queue_size = 0;
+		case 'p':
+			if(0 == strcmp(optarg, "compare"))
+			{
+				compare_lines = true;
+			}
+			else if(false == parse_routing(optarg, &model.routing))
+			{
+				std::cerr << "unknown routing " << optarg << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
 
-	pthread_t threads[NUMBER_OF_TELLERS];
-	void* results[NUMBER_OF_TELLERS];
+		case 'T':
+			trace_path = optarg;
+			break;
 
-	timesleep.tv_sec = 1;
+		case 'm':
+			series_path = optarg;
+			break;
 
-	clock_gettime(CLOCK_REALTIME,&current_time);
+		case 'L':
+			live_name = optarg;
+			break;
 
-	// decide closing time
-	closing_time.tv_sec = current_time.tv_sec + BANKHOURS_SIMULATION_TIME;
+		case 'k':
+			checkpoint_path = optarg;
+			break;
 
-	//std::cout << closing_time.tv_sec << std::endl;
-	//std::cout << current_time.tv_sec << std::endl;
-	//std::cout << "Started" << std::endl;
+		case 'R':
+			resume_path = optarg;
+			virtual_time = true;
+			break;
 
-	pthread_mutex_init(&queue_semaphore, NULL);
-	pthread_mutex_init(&previous_queue_semaphore, NULL);
+		case 'r':
+			replications.max_replications = strtoul(optarg, NULL, 10);
+			break;
 
-	// create the three threads corresponding to each teller
-	for(int i=0;i<NUMBER_OF_TELLERS;i++)
-	{
-		pthread_create(&threads[i], NULL, &eachTeller, NULL);
-	}
+		case 'w':
+			replications.target_relative_width = strtod(optarg, NULL);
+			break;
 
-	// create new customers till bank is open
-	while(closing_time.tv_sec > current_time.tv_sec)
-	{
-		//get current time to check if its time to close bank
-		clock_gettime(CLOCK_REALTIME,&current_time);
+		case 'j':
+			replications.threads = strtoul(optarg, NULL, 10);
+			break;
 
-		//create customer add in queue
-		customer new_customer = create_customer(current_time);
+		case 'b':
+			branches = strtoul(optarg, NULL, 10);
+			break;
 
-		//put customer in queue
-		pthread_mutex_lock(&queue_semaphore);
-		customers.push(new_customer);
-		if(max_queue_size < customers.size() )
-		{
-			max_queue_size = customers.size();
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
 		}
-		pthread_mutex_unlock(&queue_semaphore);
+	}
 
-		//sleep till it's time to create next customer
-		wait_minute = (rand()%4) + 1;
-		timesleep = simulated_minutes_to_time(wait_minute);
+	// tellers' own lines are always first come first served
+	if((SINGLE_QUEUE != model.routing || compare_lines) && (FIFO != model.discipline || compare_queues))
+	{
+		std::cerr << "a line per teller is always fifo, -p and -q cannot be combined" << std::endl;
+		return EXIT_FAILURE;
+	}
 
-		//std::cout << "sleeping for " << timesleep.tv_sec  << std::endl;
-		nanosleep(&timesleep,&rem);
+	if((NULL != checkpoint_path || NULL != resume_path) && (!virtual_time || compare_queues || compare_lines || replications.max_replications > 0 || coroutine_tellers > 0))
+	{
+		std::cerr << "checkpoints need -v" << std::endl;
+		return EXIT_FAILURE;
+	}
 
-		total_customers++;
-		//std::cout << current_time.tv_sec << std::endl;
+	if((NULL != trace_path || NULL != series_path) && (compare_queues || compare_lines || replications.max_replications > 0 || coroutine_tellers > 0))
+	{
+		std::cerr << "tracing and sampling need -v or the wall clock simulation" << std::endl;
+		return EXIT_FAILURE;
 	}
-	//std::cout << "Ended" << total_customers << std::endl;
 
-	//bank is closed
-	BankClosed = true;
+	if(NULL != live_name && (virtual_time || compare_queues || compare_lines || replications.max_replications > 0 || coroutine_tellers > 0 || branches > 0))
+	{
+		std::cerr << "live metrics need the wall clock simulation" << std::endl;
+		return EXIT_FAILURE;
+	}
 
-	//wait till all tellers service customers inside bank
-	while(customers.size() > 0)
+	if(branches > 0 && (compare_queues || compare_lines || replications.max_replications > 0 || coroutine_tellers > 0 || NULL != trace_path || NULL != series_path || NULL != checkpoint_path || NULL != resume_path))
 	{
-		//wait for 10 simulated minutes (1 second in real)
-		timesleep.tv_sec = 1;
-		timesleep.tv_nsec = 0;
-		nanosleep(&timesleep,&rem);
+		std::cerr << "-b only combines with the model options and -j" << std::endl;
+		return EXIT_FAILURE;
 	}
 
-	//wait till/check if all threads have finished execution
-	for(int i=0;i<NUMBER_OF_TELLERS;i++)
+	if(branches > 0)
 	{
-		pthread_join(threads[i],&results[i]);
+		region_params region;
+		region.branches = branches;
+		region.threads = replications.threads;
+		region.seed = seed;
+		region.model = model;
+		print_region_report(run_region(region));
+		return EXIT_SUCCESS;
 	}
 
-	// destroy
-	pthread_mutex_destroy(&queue_semaphore);
-	pthread_mutex_destroy(&previous_queue_semaphore);
+	if(compare_queues || compare_lines)
+	{
+		replications.seed = seed;
+		replications.model = model;
+		if(compare_queues)
+		{
+			compare_disciplines(replications);
+		}
+		else
+		{
+			compare_routings(replications);
+		}
+		return EXIT_SUCCESS;
+	}
 
-	double total_wait_queue = 0;
-	double max_wait_queue = 0;
-	unsigned int total_transaction_time = 0;
-	unsigned int max_transaction_time = 0;
+	if(replications.max_replications > 0)
+	{
+		replications.seed = seed;
+		replications.model = model;
+		print_replication_summary(run_replications(replications));
+		return EXIT_SUCCESS;
+	}
 
-	//std::cout << "Previous customer size " << previousCustomers.size()<< std::endl;
+	// every thread of the run writes into the same trace file
+	trace_file *trace = NULL;
+	if(NULL != trace_path)
+	{
+		trace = new trace_file;
+		if(false == trace_open(trace, trace_path))
+		{
+			std::cerr << "cannot create trace file " << trace_path << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	time_series *series = NULL;
+	if(NULL != series_path)
+	{
+		series = new time_series;
+		series_init(series, SERIES_INTERVAL);
+	}
 
-	// get information saved in another queue
-	while(previousCustomers.size() > 0)
+	bank_report report;
+	if(coroutine_tellers > 0)
 	{
-		customer temp_customer = previousCustomers.front();
-		previousCustomers.pop();
+		if(SINGLE_QUEUE != model.routing)
+		{
+			std::cerr << "a line per teller needs -v or -r" << std::endl;
+			return EXIT_FAILURE;
+		}
+		report = run_coroutine_bank(&model, seed, coroutine_tellers);
+	}
+	else if(virtual_time)
+	{
+		des_bank bank;
+		trace_buffer *events = new trace_buffer;
+		trace_buffer_init(events, trace);
+		if(NULL == resume_path)
+		{
+			des_init(&bank, &model, seed);
+		}
+		else if(false == des_resume(&bank, resume_path))
+		{
+			std::cerr << "cannot resume from " << resume_path << std::endl;
+			return EXIT_FAILURE;
+		}
+		bank.trace = events;
+		bank.series = series;
 
-		long queue_wait = time_difference_to_simulated_seconds(temp_customer.qPopTime,temp_customer.qPushTime);
-		total_wait_queue += queue_wait;
+		if(NULL == checkpoint_path)
+		{
+			des_run(&bank);
+		}
+		else
+		{
+			// checkpoints fall on whole simulated hours, also after a resume
+			sim_ticks next_checkpoint = (bank.now / CHECKPOINT_INTERVAL + 1) * CHECKPOINT_INTERVAL;
+			while(des_run_until(&bank, next_checkpoint))
+			{
+				if(false == des_checkpoint(&bank, checkpoint_path))
+				{
+					std::cerr << "cannot write checkpoint " << checkpoint_path << std::endl;
+				}
+				next_checkpoint += CHECKPOINT_INTERVAL;
+			}
+		}
+		trace_flush(events);
+		delete events;
+		report = des_report(&bank);
+	}
+	else
+	{
+		// the lock-free queue of the wall clock simulation is always FIFO
+		if(FIFO != model.discipline || SINGLE_QUEUE != model.routing)
+		{
+			std::cerr << "queue disciplines other than fifo need -v, -c or -r, a line per teller -v or -r" << std::endl;
+			return EXIT_FAILURE;
+		}
 
-		if(queue_wait > max_wait_queue)
+		live_block *live = NULL;
+		if(NULL != live_name)
 		{
-			max_wait_queue = queue_wait;
+			live = live_create(live_name);
+			if(NULL == live)
+			{
+				std::cerr << "cannot create shared memory " << live_name << std::endl;
+				return EXIT_FAILURE;
+			}
 		}
 
-		total_transaction_time += temp_customer.serviceTime;
+		report = run_wall_clock_bank(&model, seed, trace, series, live);
 
-		if(max_transaction_time < temp_customer.serviceTime )
+		if(NULL != live)
 		{
-			max_transaction_time = temp_customer.serviceTime;
+			live_destroy(live, live_name);
 		}
-		//std::cout << "wait " << queue_wait << " service time " << temp_customer.serviceTime << std::endl;
+	}
 
+	if(NULL != trace)
+	{
+		trace_close(trace);
+		delete trace;
+	}
+
+	if(NULL != series)
+	{
+		if(false == series_write(series, series_path))
+		{
+			std::cerr << "cannot write time series " << series_path << std::endl;
+		}
+		delete series;
 	}
 
 	// print information
-	std::cout << "The total number of customers serviced are " << total_customers << std::endl;
-	std::cout << "The average customer wait is " << total_wait_queue/total_customers << " Seconds" << std::endl;
-	std::cout << "The average time spent with teller is " << total_transaction_time/total_customers << " Seconds" << std::endl;
-	std::cout << "The average wait that tellers do is " << teller_average_time_waiting << " Seconds" << std::endl;
-	std::cout << "The maximum customer waiting time in queue is " << max_wait_queue << " Seconds" << std::endl;
-	std::cout << "The maximum teller waiting time is " << teller_maximum_time_waiting << " Seconds" << std::endl;
-	std::cout << "The maximum transaction time for tellers is " << max_transaction_time << " Seconds" << std::endl;
-	std::cout << "The maximum depth of the queue is " << max_queue_size << std::endl;
+	print_report(report);
 
 	return EXIT_SUCCESS;
 }
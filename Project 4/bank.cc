@@ -0,0 +1,313 @@
+#include <iostream>
+#include <math.h>
+#include <string.h>
+
+#include "bank.h"
+
+// samples are turned into simulated time this many at a time
+#define SAMPLE_CHUNK 64
+
+void default_bank_params(bank_params *params)
+{
+	params->tellers = NUMBER_OF_TELLERS;
+	params->min_arrival_minutes = MIN_ARRIVAL_MINUTES;
+	params->max_arrival_minutes = MAX_ARRIVAL_MINUTES;
+	params->min_service_seconds = MIN_SERVICE_SECONDS;
+	params->max_service_seconds = MAX_SERVICE_SECONDS;
+	params->arrival_distribution = UNIFORM;
+	params->service_distribution = UNIFORM;
+	params->discipline = FIFO;
+	params->routing = SINGLE_QUEUE;
+}
+
+bool parse_distribution(const char *name, distribution *result)
+{
+	if(0 == strcmp(name, "uniform"))
+	{
+		*result = UNIFORM;
+	}
+	else if(0 == strcmp(name, "exponential"))
+	{
+		*result = EXPONENTIAL;
+	}
+	else if(0 == strcmp(name, "lognormal"))
+	{
+		*result = LOGNORMAL;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+static const char *discipline_names[NUMBER_OF_DISCIPLINES] = {"fifo", "sjf", "priority"};
+
+static const char *routing_names[NUMBER_OF_ROUTINGS] = {"single", "jsq", "p2c"};
+
+// share of customers in each priority class, in percent
+static const int priority_class_percent[NUMBER_OF_PRIORITY_CLASSES] = {10, 30, 60};
+
+bool parse_discipline(const char *name, queue_discipline *result)
+{
+	for(int i=0;i<NUMBER_OF_DISCIPLINES;i++)
+	{
+		if(0 == strcmp(name, discipline_names[i]))
+		{
+			*result = (queue_discipline)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *discipline_name(queue_discipline discipline)
+{
+	return discipline_names[discipline];
+}
+
+bool parse_routing(const char *name, queue_routing *result)
+{
+	for(int i=0;i<NUMBER_OF_ROUTINGS;i++)
+	{
+		if(0 == strcmp(name, routing_names[i]))
+		{
+			*result = (queue_routing)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *routing_name(queue_routing routing)
+{
+	return routing_names[routing];
+}
+
+// Turns a raw sample into simulated time. low and high are in units of
+// unit seconds; a uniform sample picks a whole unit between them, the
+// other distributions are already in seconds with the same mean. Never
+// returns 0 so time always moves forward.
+static sim_ticks to_ticks(distribution kind, double sample, long low, long high, long unit)
+{
+	if(UNIFORM == kind)
+	{
+		return SECONDS_TO_TICKS((low + (long)floor(sample * (high - low + 1))) * unit);
+	}
+
+	sim_ticks ticks = seconds_to_ticks(sample);
+	return ticks < 1 ? 1 : ticks;
+}
+
+// raw sample for one draw: uniform in [0, 1), otherwise already in seconds
+static double draw(rng_state *rng, distribution kind, double mean)
+{
+	switch(kind)
+	{
+	case EXPONENTIAL:
+		return rng_exponential(rng, mean);
+
+	case LOGNORMAL:
+		return rng_lognormal(rng, log(mean) - LOGNORMAL_SIGMA * LOGNORMAL_SIGMA / 2, LOGNORMAL_SIGMA);
+
+	default:
+		return rng_uniform(rng);
+	}
+}
+
+static void fill_ticks(rng_batch *rng, distribution kind, long low, long high, long unit, sim_ticks *samples, size_t count)
+{
+	double mean = (low + high) * unit / 2.0;
+	double raw[SAMPLE_CHUNK];
+
+	for(size_t done=0;done<count;done+=SAMPLE_CHUNK)
+	{
+		size_t chunk = count - done < SAMPLE_CHUNK ? count - done : SAMPLE_CHUNK;
+		switch(kind)
+		{
+		case EXPONENTIAL:
+			rng_fill_exponential(rng, raw, chunk, mean);
+			break;
+
+		case LOGNORMAL:
+			rng_fill_lognormal(rng, raw, chunk, log(mean) - LOGNORMAL_SIGMA * LOGNORMAL_SIGMA / 2, LOGNORMAL_SIGMA);
+			break;
+
+		default:
+			rng_fill_uniform(rng, raw, chunk);
+			break;
+		}
+
+		for(size_t i=0;i<chunk;i++)
+		{
+			samples[done + i] = to_ticks(kind, raw[i], low, high, unit);
+		}
+	}
+}
+
+sim_ticks sample_arrival_gap(rng_state *rng, const bank_params *params)
+{
+	double mean = (params->min_arrival_minutes + params->max_arrival_minutes) * 60 / 2.0;
+	return to_ticks(params->arrival_distribution, draw(rng, params->arrival_distribution, mean), params->min_arrival_minutes, params->max_arrival_minutes, 60);
+}
+
+sim_ticks sample_service_time(rng_state *rng, const bank_params *params)
+{
+	double mean = (params->min_service_seconds + params->max_service_seconds) / 2.0;
+	return to_ticks(params->service_distribution, draw(rng, params->service_distribution, mean), params->min_service_seconds, params->max_service_seconds, 1);
+}
+
+int sample_priority_class(rng_state *rng)
+{
+	int percent = (int)rng_between(rng, 0, 99);
+	int priority_class = 0;
+	while(priority_class < NUMBER_OF_PRIORITY_CLASSES - 1 && percent >= priority_class_percent[priority_class])
+	{
+		percent -= priority_class_percent[priority_class];
+		priority_class++;
+	}
+	return priority_class;
+}
+
+//creates a customer, the wall clock simulation draws one at a time
+customer create_customer(const bank_params *params, sim_ticks currentTime, rng_state *random)
+{
+	customer temporaryCustomer;
+	temporaryCustomer.qPushTime = currentTime;
+	temporaryCustomer.serviceTime = sample_service_time(random, params);
+	temporaryCustomer.priority_class = 0;
+	return temporaryCustomer;
+}
+
+// block versions of the above for the virtual time simulation
+void fill_arrival_gaps(rng_batch *rng, const bank_params *params, sim_ticks *samples, size_t count)
+{
+	fill_ticks(rng, params->arrival_distribution, params->min_arrival_minutes, params->max_arrival_minutes, 60, samples, count);
+}
+
+void fill_service_times(rng_batch *rng, const bank_params *params, sim_ticks *samples, size_t count)
+{
+	fill_ticks(rng, params->service_distribution, params->min_service_seconds, params->max_service_seconds, 1, samples, count);
+}
+
+void teller_stats_init(teller_stats *stats)
+{
+	stats_init(&stats->wait_queue);
+	stats_init(&stats->transaction_time);
+	stats_init(&stats->teller_wait);
+	histogram_init(&stats->wait_queue_histogram);
+	histogram_init(&stats->transaction_time_histogram);
+	histogram_init(&stats->teller_wait_histogram);
+}
+
+// adds everything other measured to stats
+void teller_stats_merge(teller_stats *stats, const teller_stats *other)
+{
+	stats_merge(&stats->wait_queue, &other->wait_queue);
+	stats_merge(&stats->transaction_time, &other->transaction_time);
+	stats_merge(&stats->teller_wait, &other->teller_wait);
+	histogram_merge(&stats->wait_queue_histogram, &other->wait_queue_histogram);
+	histogram_merge(&stats->transaction_time_histogram, &other->transaction_time_histogram);
+	histogram_merge(&stats->teller_wait_histogram, &other->teller_wait_histogram);
+}
+
+// adds a time to an accumulator and its histogram
+static void record(stats_accumulator *stats, histogram *hist, sim_ticks time)
+{
+	stats_add(stats, ticks_to_seconds(time));
+	histogram_record(hist, time < 0 ? 0 : time / TICKS_PER_HISTOGRAM_UNIT);
+}
+
+void record_queue_wait(teller_stats *stats, sim_ticks wait)
+{
+	record(&stats->wait_queue, &stats->wait_queue_histogram, wait);
+}
+
+void record_transaction_time(teller_stats *stats, sim_ticks time)
+{
+	record(&stats->transaction_time, &stats->transaction_time_histogram, time);
+}
+
+void record_teller_wait(teller_stats *stats, sim_ticks wait)
+{
+	record(&stats->teller_wait, &stats->teller_wait_histogram, wait);
+}
+
+// percentile (0 to 100) of a histogram in seconds, a bucket's top can be
+// above anything recorded so it is capped at the real maximum
+double percentile_seconds(const histogram *hist, const stats_accumulator *stats, double percentile)
+{
+	double value = ticks_to_seconds(histogram_percentile(hist, percentile) * TICKS_PER_HISTOGRAM_UNIT);
+	return value > stats->max ? stats->max : value;
+}
+
+// prints p50/p90/p99/p99.9 of a histogram in seconds
+static void print_percentiles(const char *name, const histogram *hist, const stats_accumulator *stats)
+{
+	static const double percentiles[] = {50, 90, 99, 99.9};
+
+	std::cout << "The " << name << " percentiles p50/p90/p99/p99.9 are ";
+	for(unsigned int i=0;i<sizeof(percentiles)/sizeof(percentiles[0]);i++)
+	{
+		if(i > 0)
+		{
+			std::cout << " / ";
+		}
+		std::cout << percentile_seconds(hist, stats, percentiles[i]);
+	}
+	std::cout << " Seconds" << std::endl;
+}
+
+// merges what every teller measured into the end of day metrics
+bank_report build_report(const teller_stats *tellers, int number_of_tellers, unsigned int total_customers, unsigned int max_queue_size)
+{
+	bank_report report;
+
+	teller_stats_init(&report.all_tellers);
+	stats_init(&report.wakeup_lateness);
+	report.teller_average_time_waiting = 0;
+	for(int i=0;i<number_of_tellers;i++)
+	{
+		teller_stats_merge(&report.all_tellers, &tellers[i]);
+
+		// average of each teller's average wait
+		report.teller_average_time_waiting += tellers[i].teller_wait.mean/number_of_tellers;
+	}
+
+	report.total_customers = total_customers;
+	report.average_wait_queue = report.all_tellers.wait_queue.mean;
+	report.average_transaction_time = report.all_tellers.transaction_time.mean;
+	report.max_wait_queue = report.all_tellers.wait_queue.max;
+	report.teller_maximum_time_waiting = report.all_tellers.teller_wait.max;
+	report.max_transaction_time = report.all_tellers.transaction_time.max;
+	report.max_queue_size = max_queue_size;
+	report.stolen_customers = 0;
+	return report;
+}
+
+// prints the metrics gathered during the day
+void print_report(const bank_report &report)
+{
+	std::cout << "The total number of customers serviced are " << report.total_customers << std::endl;
+	std::cout << "The average customer wait is " << report.average_wait_queue << " Seconds" << std::endl;
+	std::cout << "The average time spent with teller is " << report.average_transaction_time << " Seconds" << std::endl;
+	std::cout << "The average wait that tellers do is " << report.teller_average_time_waiting << " Seconds" << std::endl;
+	std::cout << "The maximum customer waiting time in queue is " << report.max_wait_queue << " Seconds" << std::endl;
+	std::cout << "The maximum teller waiting time is " << report.teller_maximum_time_waiting << " Seconds" << std::endl;
+	std::cout << "The maximum transaction time for tellers is " << report.max_transaction_time << " Seconds" << std::endl;
+	std::cout << "The maximum depth of the queue is " << report.max_queue_size << std::endl;
+	if(report.stolen_customers > 0)
+	{
+		std::cout << report.stolen_customers << " customers were taken from another teller's line" << std::endl;
+	}
+	print_percentiles("customer wait", &report.all_tellers.wait_queue_histogram, &report.all_tellers.wait_queue);
+	print_percentiles("transaction time", &report.all_tellers.transaction_time_histogram, &report.all_tellers.transaction_time);
+	print_percentiles("teller wait", &report.all_tellers.teller_wait_histogram, &report.all_tellers.teller_wait);
+
+	if(report.wakeup_lateness.count > 0)
+	{
+		std::cout << "Timer wakeups were late by " << report.wakeup_lateness.mean << " us on average, "
+				<< stats_quantile(&report.wakeup_lateness, 0.99) << " us at the 99th percentile and "
+				<< report.wakeup_lateness.max << " us at most (" << report.wakeup_lateness.count << " wakeups)" << std::endl;
+	}
+}
@@ -0,0 +1,159 @@
+#ifndef _bank_
+#define _bank_
+
+#include <stddef.h>
+
+#include "histogram.h"
+#include "rng.h"
+#include "sim_time.h"
+#include "stats.h"
+
+// simulation parameters, only defined here so both the wall clock
+// simulation and the virtual time simulation use the same model
+
+#define BANKHOURS 7
+
+// defaults, every simulation takes them from bank_params
+#define NUMBER_OF_TELLERS 3
+
+// most customers that can be waiting in the queue, the bank sees at most
+// 7 * 60 arrivals a day so this is never reached (power of two)
+#define CUSTOMER_QUEUE_CAPACITY 1024
+
+// a new customer arrives every 1 to 4 minutes
+#define MIN_ARRIVAL_MINUTES 1
+#define MAX_ARRIVAL_MINUTES 4
+
+// each transaction takes 30 seconds to 6 minutes
+#define MIN_SERVICE_SECONDS 30
+#define MAX_SERVICE_SECONDS 360
+
+// tellers take a break every 30 to 60 minutes for 1 to 4 minutes
+#define MIN_BREAK_INTERVAL_MINUTES 30
+#define MAX_BREAK_INTERVAL_MINUTES 60
+#define MIN_BREAK_MINUTES 1
+#define MAX_BREAK_MINUTES 4
+
+// spread of the lognormal distribution (sigma of the underlying normal)
+#define LOGNORMAL_SIGMA 0.5
+
+// customers come in three priority classes for the PRIORITY_CLASSES
+// discipline, 10% in class 0 (served first), 30% in 1 and 60% in 2
+#define NUMBER_OF_PRIORITY_CLASSES 3
+
+// how arrival gaps and transaction times are drawn. UNIFORM is the model
+// in the problem statement (whole minutes / whole seconds between the
+// limits), the others keep the same mean.
+typedef enum
+{
+	UNIFORM = 0,
+	EXPONENTIAL,
+	LOGNORMAL
+} distribution;
+
+// order in which waiting customers are served (customer_queue.h), only
+// the virtual time simulations can reorder the queue
+typedef enum
+{
+	FIFO = 0,
+	SHORTEST_SERVICE_FIRST,
+	PRIORITY_CLASSES
+} queue_discipline;
+
+#define NUMBER_OF_DISCIPLINES 3
+
+// SINGLE_QUEUE is the one line of the problem statement. The others give
+// every teller its own line (virtual time only): arriving customers join
+// the shortest line, or the shorter of two picked at random, and a teller
+// with an empty line takes the last customer of the longest one.
+typedef enum
+{
+	SINGLE_QUEUE = 0,
+	JOIN_SHORTEST_QUEUE,
+	POWER_OF_TWO_CHOICES
+} queue_routing;
+
+#define NUMBER_OF_ROUTINGS 3
+
+typedef struct
+{
+	int tellers;
+	long min_arrival_minutes;
+	long max_arrival_minutes;
+	long min_service_seconds;
+	long max_service_seconds;
+	distribution arrival_distribution;
+	distribution service_distribution;
+	queue_discipline discipline;
+	queue_routing routing;
+} bank_params;
+
+//customer struct definition, times are simulated time since opening
+typedef struct
+{
+	sim_ticks qPushTime;		// The arrival time of the customer
+	sim_ticks qPopTime;			// The time the customer left the queue
+	sim_ticks serviceTime;		// How long the transaction takes
+	int priority_class;			// 0 is served first with PRIORITY_CLASSES
+} customer;
+
+// percentiles are recorded in simulated milliseconds
+#define TICKS_PER_HISTOGRAM_UNIT (TICKS_PER_SECOND / 1000)
+
+// what each teller measures while working, merged when the day is over
+typedef struct
+{
+	stats_accumulator wait_queue;		// time its customers spent in the queue
+	stats_accumulator transaction_time;	// time spent with each customer
+	stats_accumulator teller_wait;		// time waiting for each customer
+
+	// the same three for tail percentiles
+	histogram wait_queue_histogram;
+	histogram transaction_time_histogram;
+	histogram teller_wait_histogram;
+} teller_stats;
+
+// metrics reported at the end of the day, all times in simulated seconds
+typedef struct
+{
+	unsigned int total_customers;
+	double average_wait_queue;
+	double average_transaction_time;
+	double teller_average_time_waiting;
+	double max_wait_queue;
+	double teller_maximum_time_waiting;
+	double max_transaction_time;
+	unsigned int max_queue_size;
+	unsigned int stolen_customers;	// taken from another teller's line
+
+	// every teller's measurements merged together
+	teller_stats all_tellers;
+
+	// how late real clock sleeps woke up, in real microseconds
+	// (wall clock mode only)
+	stats_accumulator wakeup_lateness;
+} bank_report;
+
+void default_bank_params(bank_params *params);
+bool parse_distribution(const char *name, distribution *result);
+bool parse_discipline(const char *name, queue_discipline *result);
+const char *discipline_name(queue_discipline discipline);
+bool parse_routing(const char *name, queue_routing *result);
+const char *routing_name(queue_routing routing);
+sim_ticks sample_arrival_gap(rng_state *rng, const bank_params *params);
+sim_ticks sample_service_time(rng_state *rng, const bank_params *params);
+int sample_priority_class(rng_state *rng);
+customer create_customer(const bank_params *params, sim_ticks currentTime, rng_state *random);
+void fill_arrival_gaps(rng_batch *rng, const bank_params *params, sim_ticks *samples, size_t count);
+void fill_service_times(rng_batch *rng, const bank_params *params, sim_ticks *samples, size_t count);
+
+void teller_stats_init(teller_stats *stats);
+void teller_stats_merge(teller_stats *stats, const teller_stats *other);
+void record_queue_wait(teller_stats *stats, sim_ticks wait);
+void record_transaction_time(teller_stats *stats, sim_ticks time);
+void record_teller_wait(teller_stats *stats, sim_ticks wait);
+double percentile_seconds(const histogram *hist, const stats_accumulator *stats, double percentile);
+bank_report build_report(const teller_stats *tellers, int number_of_tellers, unsigned int total_customers, unsigned int max_queue_size);
+void print_report(const bank_report &report);
+
+#endif
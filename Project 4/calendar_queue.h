@@ -0,0 +1,190 @@
+#ifndef _calendar_queue_
+#define _calendar_queue_
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+
+#include "sim_time.h"
+
+// Calendar queue (R. Brown, 1988) for the pending event list.
+//
+// Time is cut into days of a fixed width and the days are spread over a
+// ring of buckets like the days of a year over a desk calendar: an event
+// goes into bucket (time / width) % buckets, and the earliest event is
+// found by walking the ring from today's bucket, only taking events that
+// fall inside the day being looked at. When the number of buckets tracks
+// the number of events and the width tracks the spacing between the next
+// few events, push and pop take O(1) amortised time instead of the
+// O(log n) of a binary heap.
+//
+// T needs a sim_ticks time member, LATER orders two events the same way
+// as the comparator of a std::priority_queue (true if the first one comes
+// out later), so events with equal times come out in the same order.
+// Like the discrete event simulation, events must not be pushed earlier
+// than the last one popped.
+
+#define CALENDAR_MIN_BUCKETS 16
+
+// how many of the earliest events are used to guess the day width
+#define CALENDAR_WIDTH_SAMPLE 32
+
+template <typename T, typename LATER>
+class calendar_queue
+{
+public:
+	calendar_queue() : width(TICKS_PER_SECOND), count(0)
+	{
+		buckets.resize(CALENDAR_MIN_BUCKETS);
+		mask = CALENDAR_MIN_BUCKETS - 1;
+		start_day(0);
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	void push(const T &event)
+	{
+		insert(event);
+		count++;
+
+		// an event for a day the search already went past
+		if(event.time < day_end - width)
+		{
+			start_day(event.time);
+		}
+
+		if(count > 2 * buckets.size())
+		{
+			resize(2 * buckets.size());
+		}
+	}
+
+	// earliest event, the queue must not be empty
+	const T &top()
+	{
+		find_earliest();
+		return buckets[current].back();
+	}
+
+	// appends every pending event, in no particular order
+	void contents(std::vector<T> *result) const
+	{
+		for(size_t i=0;i<buckets.size();i++)
+		{
+			result->insert(result->end(), buckets[i].begin(), buckets[i].end());
+		}
+	}
+
+	void pop()
+	{
+		find_earliest();
+		buckets[current].pop_back();
+		count--;
+
+		if(count < buckets.size() / 2 && buckets.size() > CALENDAR_MIN_BUCKETS)
+		{
+			resize(buckets.size() / 2);
+		}
+	}
+
+private:
+	// every bucket is sorted latest first so the earliest is at the back
+	void insert(const T &event)
+	{
+		std::vector<T> &bucket = buckets[(size_t)(event.time / width) & mask];
+		bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), event, LATER()), event);
+	}
+
+	void start_day(sim_ticks time)
+	{
+		current = (size_t)(time / width) & mask;
+		day_end = (time / width + 1) * width;
+	}
+
+	// moves current to the bucket holding the earliest event
+	void find_earliest()
+	{
+		for(size_t i=0;i<buckets.size();i++)
+		{
+			const std::vector<T> &bucket = buckets[current];
+			if(!bucket.empty() && bucket.back().time < day_end)
+			{
+				return;
+			}
+			current = (current + 1) & mask;
+			day_end += width;
+		}
+
+		// nothing within a whole year, look at the earliest of every bucket
+		size_t earliest = buckets.size();
+		for(size_t i=0;i<buckets.size();i++)
+		{
+			if(!buckets[i].empty() && (earliest == buckets.size() || LATER()(buckets[earliest].back(), buckets[i].back())))
+			{
+				earliest = i;
+			}
+		}
+		start_day(buckets[earliest].back().time);
+	}
+
+	// rebuilds the calendar with a new number of buckets and a day width
+	// of about three times the average spacing of the next few events
+	void resize(size_t number_of_buckets)
+	{
+		std::vector<T> events;
+		events.reserve(count);
+		for(size_t i=0;i<buckets.size();i++)
+		{
+			events.insert(events.end(), buckets[i].begin(), buckets[i].end());
+		}
+
+		size_t sample = std::min(events.size(), (size_t)CALENDAR_WIDTH_SAMPLE);
+		if(sample > 1)
+		{
+			std::partial_sort(events.begin(), events.begin() + sample, events.end(), LATER_REVERSED());
+			sim_ticks spacing = (events[sample - 1].time - events[0].time) / (sim_ticks)(sample - 1);
+			width = std::max((sim_ticks)1, 3 * spacing);
+		}
+
+		sim_ticks earliest = events.empty() ? day_end - width : events[0].time;
+		for(size_t i=1;i<events.size();i++)
+		{
+			earliest = std::min(earliest, events[i].time);
+		}
+
+		buckets.clear();
+		buckets.resize(number_of_buckets);
+		mask = number_of_buckets - 1;
+		for(size_t i=0;i<events.size();i++)
+		{
+			insert(events[i]);
+		}
+		start_day(earliest);
+	}
+
+	// orders earliest first for the width sample
+	struct LATER_REVERSED
+	{
+		bool operator()(const T &event1, const T &event2) const
+		{
+			return LATER()(event2, event1);
+		}
+	};
+
+	std::vector< std::vector<T> > buckets;
+	size_t mask;			// number of buckets - 1, always a power of two
+	sim_ticks width;		// simulated time covered by one bucket per year
+	size_t current;			// bucket of the day being searched
+	sim_ticks day_end;		// end of the day being searched
+	size_t count;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+
+typedef struct
+{
+	const char *data;
+	size_t left;
+} checkpoint_reader;
+
+static void put(std::vector<char> *out, const void *data, size_t size)
+{
+	out->insert(out->end(), (const char *)data, (const char *)data + size);
+}
+
+template <typename T>
+static void put_value(std::vector<char> *out, const T &value)
+{
+	put(out, &value, sizeof(value));
+}
+
+static bool get(checkpoint_reader *in, void *data, size_t size)
+{
+	if(in->left < size)
+	{
+		return false;
+	}
+	memcpy(data, in->data, size);
+	in->data += size;
+	in->left -= size;
+	return true;
+}
+
+template <typename T>
+static bool get_value(checkpoint_reader *in, T *value)
+{
+	return get(in, value, sizeof(*value));
+}
+
+// customers as a count followed by the customers
+static void put_customers(std::vector<char> *out, const std::vector<customer> &customers)
+{
+	put_value(out, (uint64_t)customers.size());
+	put(out, customers.data(), customers.size() * sizeof(customer));
+}
+
+static bool get_customers(checkpoint_reader *in, std::vector<customer> *customers)
+{
+	uint64_t count;
+	if(!get_value(in, &count) || count > in->left / sizeof(customer))
+	{
+		return false;
+	}
+	customers->resize(count);
+	return get(in, customers->data(), count * sizeof(customer));
+}
+
+bool des_checkpoint(const des_bank *bank, const char *path)
+{
+	std::vector<char> out;
+	out.reserve(sizeof(des_bank) + bank->params.tellers * sizeof(des_teller));
+
+	put(&out, CHECKPOINT_MAGIC, 8);
+	put_value(&out, (uint32_t)CHECKPOINT_VERSION);
+	put_value(&out, bank->params);
+
+	put_value(&out, bank->now);
+	put_value(&out, bank->closing_time);
+	put_value(&out, bank->BankClosed);
+	put_value(&out, bank->next_sequence);
+	put_value(&out, bank->random);
+	put_value(&out, bank->sample_random);
+	put_value(&out, bank->class_random);
+	put_value(&out, bank->route_random);
+	put_value(&out, bank->arrival_samples);
+	put_value(&out, bank->arrival_next);
+	put_value(&out, bank->service_samples);
+	put_value(&out, bank->service_next);
+	put_value(&out, bank->waiting);
+	put_value(&out, bank->total_customers);
+	put_value(&out, bank->max_queue_size);
+	put_value(&out, bank->stolen_customers);
+	put_value(&out, bank->next_sample);
+
+	std::vector<des_event> events;
+	bank->events.contents(&events);
+	put_value(&out, (uint64_t)events.size());
+	put(&out, events.data(), events.size() * sizeof(des_event));
+
+	std::vector<customer> customers;
+	bank->customers.contents(&customers);
+	put_customers(&out, customers);
+
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		const des_teller *current_teller = &bank->tellers[i];
+		put_value(&out, current_teller->busy);
+		put_value(&out, current_teller->on_break);
+		put_value(&out, current_teller->finished);
+		put_value(&out, current_teller->lastbreak);
+		put_value(&out, current_teller->breakAfter);
+		put_value(&out, current_teller->idle_since);
+		put_value(&out, current_teller->idle_pending);
+		put_value(&out, current_teller->current);
+		put_customers(&out, std::vector<customer>(current_teller->line.begin(), current_teller->line.end()));
+		put_value(&out, current_teller->stats);
+	}
+
+	// write next to the checkpoint and swap it in
+	std::string temporary_path = std::string(path) + ".tmp";
+	int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+	{
+		return false;
+	}
+	bool written = (ssize_t)out.size() == write(fd, out.data(), out.size());
+	written = written && 0 == fsync(fd);
+	written = 0 == close(fd) && written;
+	if(!written || 0 != rename(temporary_path.c_str(), path))
+	{
+		return false;
+	}
+
+	// the rename only survives a crash once the directory is on disk too
+	std::string directory = std::string(path).substr(0, std::string(path).find_last_of('/') + 1);
+	int directory_fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+	if(directory_fd < 0)
+	{
+		return false;
+	}
+	bool synced = 0 == fsync(directory_fd);
+	return 0 == close(directory_fd) && synced;
+}
+
+// replaces the bank with the checkpointed one, returns false if the file
+// could not be read or is not a checkpoint
+bool des_resume(des_bank *bank, const char *path)
+{
+	std::vector<char> file_data;
+	int fd = open(path, O_RDONLY);
+	struct stat file_status;
+	if(fd < 0)
+	{
+		return false;
+	}
+	if(0 != fstat(fd, &file_status))
+	{
+		close(fd);
+		return false;
+	}
+	file_data.resize(file_status.st_size);
+	bool read_all = (ssize_t)file_data.size() == read(fd, file_data.data(), file_data.size());
+	close(fd);
+
+	checkpoint_reader in = {file_data.data(), read_all ? file_data.size() : 0};
+	char magic[8];
+	uint32_t version;
+	bank_params params;
+	if(!get(&in, magic, sizeof(magic)) || 0 != memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic))
+		|| !get_value(&in, &version) || CHECKPOINT_VERSION != version
+		|| !get_value(&in, &params) || params.tellers < 1)
+	{
+		return false;
+	}
+
+	// sizes the tellers, then everything is overwritten
+	des_init(bank, &params, 0);
+
+	bool valid = get_value(&in, &bank->now)
+		&& get_value(&in, &bank->closing_time)
+		&& get_value(&in, &bank->BankClosed)
+		&& get_value(&in, &bank->next_sequence)
+		&& get_value(&in, &bank->random)
+		&& get_value(&in, &bank->sample_random)
+		&& get_value(&in, &bank->class_random)
+		&& get_value(&in, &bank->route_random)
+		&& get_value(&in, &bank->arrival_samples)
+		&& get_value(&in, &bank->arrival_next)
+		&& get_value(&in, &bank->service_samples)
+		&& get_value(&in, &bank->service_next)
+		&& get_value(&in, &bank->waiting)
+		&& get_value(&in, &bank->total_customers)
+		&& get_value(&in, &bank->max_queue_size)
+		&& get_value(&in, &bank->stolen_customers)
+		&& get_value(&in, &bank->next_sample);
+
+	uint64_t event_count = 0;
+	valid = valid && get_value(&in, &event_count) && event_count <= in.left / sizeof(des_event);
+	if(!valid)
+	{
+		return false;
+	}
+	std::vector<des_event> events(event_count);
+	valid = get(&in, events.data(), event_count * sizeof(des_event));
+
+	// events come out by time and sequence, so the bucket layout does not matter
+	bank->events = calendar_queue<des_event, des_event_later>();
+	for(size_t i=0;i<events.size();i++)
+	{
+		bank->events.push(events[i]);
+	}
+
+	std::vector<customer> customers;
+	valid = valid && get_customers(&in, &customers);
+	bank->customers = customer_queue(params.discipline);
+	for(size_t i=0;i<customers.size();i++)
+	{
+		bank->customers.push(customers[i]);
+	}
+
+	for(int i=0;i<params.tellers && valid;i++)
+	{
+		des_teller *current_teller = &bank->tellers[i];
+		valid = get_value(&in, &current_teller->busy)
+			&& get_value(&in, &current_teller->on_break)
+			&& get_value(&in, &current_teller->finished)
+			&& get_value(&in, &current_teller->lastbreak)
+			&& get_value(&in, &current_teller->breakAfter)
+			&& get_value(&in, &current_teller->idle_since)
+			&& get_value(&in, &current_teller->idle_pending)
+			&& get_value(&in, &current_teller->current)
+			&& get_customers(&in, &customers)
+			&& get_value(&in, &current_teller->stats);
+		current_teller->line.assign(customers.begin(), customers.end());
+	}
+
+	return valid && 0 == in.left;
+}
@@ -0,0 +1,28 @@
+#ifndef _checkpoint_
+#define _checkpoint_
+
+#include "des.h"
+
+// Checkpoint and resume of a discrete event simulation. A checkpoint holds
+// everything the rest of the day depends on: clock, pending events,
+// waiting customers, every teller (lastbreak, breakAfter, idle time, its
+// line and statistics), every random stream and the counters. A bank
+// resumed from it produces bit for bit the same results as one that was
+// never stopped.
+//
+// The state is serialised into memory and written with one write to a
+// temporary file that is then renamed over the checkpoint, so a crash
+// while writing leaves the previous checkpoint intact.
+//
+// Traces and time series are outputs of the run and are not saved.
+
+#define CHECKPOINT_MAGIC "BANKCKPT"
+#define CHECKPOINT_VERSION 1
+
+// simulated time between checkpoints with -k
+#define CHECKPOINT_INTERVAL TICKS_PER_HOUR
+
+bool des_checkpoint(const des_bank *bank, const char *path);
+bool des_resume(des_bank *bank, const char *path);
+
+#endif
@@ -0,0 +1,227 @@
+#include "coro.h"
+
+// resumes waiter at the given simulated time
+static void wake_at(coro_bank *bank, coro_waiter *waiter, sim_ticks time)
+{
+	coro_timer timer;
+	timer.time = time;
+	timer.sequence = bank->next_sequence++;
+	timer.waiter = waiter;
+	timer.generation = waiter->generation;
+	bank->timers.push(timer);
+}
+
+// co_await sleep_until(...) suspends until the simulated time comes
+struct sleep_until
+{
+	coro_bank *bank;
+	coro_waiter *waiter;
+	sim_ticks time;
+
+	bool await_ready() const { return false; }
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		waiter->handle = handle;
+		waiter->generation++;
+		wake_at(bank, waiter, time);
+	}
+	void await_resume() {}
+};
+
+// co_await wait_for_customer(...) suspends an idle teller until a customer
+// arrives, the bank closes or the deadline (its next break) passes
+struct wait_for_customer
+{
+	coro_bank *bank;
+	coro_waiter *waiter;
+	sim_ticks deadline;
+
+	bool await_ready() const { return !bank->customers.empty() || bank->BankClosed; }
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		waiter->handle = handle;
+		waiter->generation++;
+		waiter->idle = true;
+		bank->idle_tellers.push_back(waiter);
+		wake_at(bank, waiter, deadline);
+	}
+	void await_resume()
+	{
+		waiter->idle = false;
+	}
+};
+
+// wakes the longest waiting idle teller right now, if there is one
+static void wake_idle_teller(coro_bank *bank)
+{
+	while(!bank->idle_tellers.empty())
+	{
+		coro_waiter *waiter = bank->idle_tellers.front();
+		bank->idle_tellers.pop_front();
+
+		// left the list already because its break came due
+		if(!waiter->idle)
+		{
+			continue;
+		}
+
+		waiter->idle = false;
+		waiter->generation++;	// cancels its break deadline
+		wake_at(bank, waiter, bank->now);
+		return;
+	}
+}
+
+static coro_task teller(coro_bank *bank, coro_teller *self)
+{
+	sim_ticks lastbreak = 0;
+	sim_ticks breakAfter = MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+	sim_ticks waiting_since = 0;
+	sim_ticks idle_pending = 0;
+
+	while(1)
+	{
+		if(bank->customers.empty() && bank->BankClosed)
+		{
+			//no customer and bank is closed, go home
+			co_return;
+		}
+
+		//check if time for break
+		if(bank->now >= lastbreak + breakAfter)
+		{
+			idle_pending += bank->now - waiting_since;
+			lastbreak = bank->now;
+			breakAfter = MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+
+			// an arrival wakes one teller, if it was this one pass the customer on
+			if(!bank->customers.empty())
+			{
+				wake_idle_teller(bank);
+			}
+			co_await sleep_until{bank, &self->waiter, bank->now + MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_MINUTES, MAX_BREAK_MINUTES))};
+			waiting_since = bank->now;
+			continue;
+		}
+
+		if(bank->customers.empty())
+		{
+			co_await wait_for_customer{bank, &self->waiter, lastbreak + breakAfter};
+			continue;
+		}
+
+		customer current_customer = bank->customers.front();
+		bank->customers.pop();
+		current_customer.qPopTime = bank->now;
+
+		sim_ticks wait_time = idle_pending + bank->now - waiting_since;
+		record_teller_wait(&bank->stats, wait_time);
+		self->total_time_waiting += ticks_to_seconds(wait_time);
+		idle_pending = 0;
+		record_queue_wait(&bank->stats, current_customer.qPopTime - current_customer.qPushTime);
+
+		co_await sleep_until{bank, &self->waiter, bank->now + current_customer.serviceTime};
+
+		record_transaction_time(&bank->stats, current_customer.serviceTime);
+		self->customers_serviced++;
+		waiting_since = bank->now;
+	}
+}
+
+static coro_task generator(coro_bank *bank, coro_waiter *self)
+{
+	sim_ticks next_arrival = 0;
+
+	while(bank->closing_time > next_arrival)
+	{
+		customer new_customer;
+		new_customer.qPushTime = bank->now;
+		new_customer.qPopTime = 0;
+		new_customer.serviceTime = sample_service_time(&bank->random, &bank->params);
+		new_customer.priority_class = sample_priority_class(&bank->class_random);
+
+		bank->customers.push(new_customer);
+		if(bank->max_queue_size < bank->customers.size())
+		{
+			bank->max_queue_size = bank->customers.size();
+		}
+		bank->total_customers++;
+		wake_idle_teller(bank);
+
+		next_arrival += sample_arrival_gap(&bank->random, &bank->params);
+		co_await sleep_until{bank, self, next_arrival};
+	}
+
+	//bank is closed, wake every idle teller so they can go home
+	bank->BankClosed = true;
+	while(!bank->idle_tellers.empty())
+	{
+		wake_idle_teller(bank);
+	}
+}
+
+// runs the day on this thread with any number of coroutine tellers
+bank_report run_coroutine_bank(const bank_params *params, unsigned int seed, unsigned int number_of_tellers)
+{
+	coro_bank *bank = new coro_bank;
+	bank->now = 0;
+	bank->closing_time = BANKHOURS * TICKS_PER_HOUR;
+	bank->BankClosed = false;
+	bank->next_sequence = 0;
+	bank->params = *params;
+	rng_seed(&bank->random, seed);
+	rng_seed(&bank->class_random, seed ^ 0xC1A55);
+	bank->customers = customer_queue(params->discipline);
+	teller_stats_init(&bank->stats);
+	bank->total_customers = 0;
+	bank->max_queue_size = 0;
+
+	coro_teller empty_teller = {{nullptr, 0, false}, 0, 0};
+	bank->tellers.assign(number_of_tellers, empty_teller);
+
+	std::vector<coro_task> tasks;
+	tasks.reserve(number_of_tellers + 1);
+	coro_waiter generator_waiter = {nullptr, 0, false};
+
+	// everyone starts when the bank opens, the generator last so the
+	// first customer finds every teller waiting
+	for(unsigned int i=0;i<number_of_tellers;i++)
+	{
+		tasks.push_back(teller(bank, &bank->tellers[i]));
+		bank->tellers[i].waiter.handle = tasks.back().handle;
+		wake_at(bank, &bank->tellers[i].waiter, 0);
+	}
+	tasks.push_back(generator(bank, &generator_waiter));
+	generator_waiter.handle = tasks.back().handle;
+	wake_at(bank, &generator_waiter, 0);
+
+	while(!bank->timers.empty())
+	{
+		coro_timer timer = bank->timers.top();
+		bank->timers.pop();
+
+		// the coroutine was woken another way since this was scheduled
+		if(timer.generation != timer.waiter->generation)
+		{
+			continue;
+		}
+
+		bank->now = timer.time;
+		timer.waiter->handle.resume();
+	}
+
+	bank_report report = build_report(&bank->stats, 1, bank->total_customers, bank->max_queue_size);
+
+	// build_report saw a single teller, redo the average of each teller's average
+	report.teller_average_time_waiting = 0;
+	for(unsigned int i=0;i<number_of_tellers;i++)
+	{
+		if(bank->tellers[i].customers_serviced > 0)
+		{
+			report.teller_average_time_waiting += (bank->tellers[i].total_time_waiting / bank->tellers[i].customers_serviced) / number_of_tellers;
+		}
+	}
+
+	delete bank;
+	return report;
+}
@@ -0,0 +1,108 @@
+#ifndef _coro_
+#define _coro_
+
+#include <coroutine>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "bank.h"
+#include "customer_queue.h"
+#include "rng.h"
+
+// Coroutine version of the bank (needs C++20). Every teller and the
+// customer generator is a coroutine that suspends on simulated time,
+// and one thread resumes them in time order. A teller costs a coroutine
+// frame and a few counters instead of a thread stack, so the number of
+// tellers is only limited by memory (10000 tellers is a few MB).
+
+// a coroutine that starts suspended and is resumed by the scheduler
+struct coro_task
+{
+	struct promise_type
+	{
+		coro_task get_return_object()
+		{
+			return coro_task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() {}
+	};
+
+	explicit coro_task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+	coro_task(coro_task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+	coro_task(const coro_task &) = delete;
+	~coro_task()
+	{
+		if(handle)
+		{
+			handle.destroy();
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+// a suspended coroutine. generation changes every time it suspends, so a
+// wakeup scheduled for an earlier suspension is recognised as stale
+typedef struct
+{
+	std::coroutine_handle<> handle;
+	unsigned long generation;
+	bool idle;					// waiting in the idle teller list
+} coro_waiter;
+
+typedef struct
+{
+	sim_ticks time;
+	unsigned long sequence;
+	coro_waiter *waiter;
+	unsigned long generation;
+} coro_timer;
+
+struct coro_timer_later
+{
+	bool operator()(const coro_timer &timer1, const coro_timer &timer2) const
+	{
+		if(timer1.time != timer2.time)
+		{
+			return timer1.time > timer2.time;
+		}
+		return timer1.sequence > timer2.sequence;
+	}
+};
+
+// what each coroutine teller keeps for itself
+typedef struct
+{
+	coro_waiter waiter;
+	double total_time_waiting;	// seconds, for the average of averages
+	unsigned long customers_serviced;
+} coro_teller;
+
+typedef struct
+{
+	sim_ticks now;
+	sim_ticks closing_time;
+	bool BankClosed;
+	unsigned long next_sequence;
+	bank_params params;
+	rng_state random;
+	rng_state class_random;		// priority classes
+
+	std::priority_queue<coro_timer, std::vector<coro_timer>, coro_timer_later> timers;
+	customer_queue customers;
+	std::deque<coro_waiter *> idle_tellers;
+	std::vector<coro_teller> tellers;
+
+	// tellers take turns on one thread, so they can share the statistics
+	teller_stats stats;
+	unsigned int total_customers;
+	unsigned int max_queue_size;
+} coro_bank;
+
+bank_report run_coroutine_bank(const bank_params *params, unsigned int seed, unsigned int number_of_tellers);
+
+#endif
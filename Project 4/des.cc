@@ -0,0 +1,403 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "des.h"
+
+// adds an event to the pending event list
+static void schedule(des_bank *bank, sim_ticks time, des_event_type type, int teller)
+{
+	des_event event;
+	event.time = time;
+	event.sequence = bank->next_sequence++;
+	event.type = type;
+	event.teller = teller;
+	bank->events.push(event);
+}
+
+// records an event at the current time if the bank is traced
+static void trace(des_bank *bank, trace_type type, int teller, uint32_t argument)
+{
+	if(NULL != bank->trace)
+	{
+		trace_record(bank->trace, type, teller, bank->now, argument);
+	}
+}
+
+// next gap between customers, refilling the block when it runs out
+static sim_ticks next_arrival_gap(des_bank *bank)
+{
+	if(bank->arrival_next == SAMPLE_BLOCK)
+	{
+		fill_arrival_gaps(&bank->sample_random, &bank->params, bank->arrival_samples, SAMPLE_BLOCK);
+		bank->arrival_next = 0;
+	}
+	return bank->arrival_samples[bank->arrival_next++];
+}
+
+static sim_ticks next_service_time(des_bank *bank)
+{
+	if(bank->service_next == SAMPLE_BLOCK)
+	{
+		fill_service_times(&bank->sample_random, &bank->params, bank->service_samples, SAMPLE_BLOCK);
+		bank->service_next = 0;
+	}
+	return bank->service_samples[bank->service_next++];
+}
+
+// customers waiting for a teller or with it
+static size_t line_length(const des_bank *bank, int teller)
+{
+	return bank->tellers[teller].line.size() + (bank->tellers[teller].busy ? 1 : 0);
+}
+
+// teller whose line a new customer joins
+static int route_customer(des_bank *bank)
+{
+	if(JOIN_SHORTEST_QUEUE == bank->params.routing)
+	{
+		int shortest = 0;
+		for(int i=1;i<bank->params.tellers;i++)
+		{
+			if(line_length(bank, i) < line_length(bank, shortest))
+			{
+				shortest = i;
+			}
+		}
+		return shortest;
+	}
+
+	if(bank->params.tellers < 2)
+	{
+		return 0;
+	}
+
+	// power of two choices, the shorter of two different lines
+	int first = rng_between(&bank->route_random, 0, bank->params.tellers - 1);
+	int second = rng_between(&bank->route_random, 0, bank->params.tellers - 2);
+	if(second >= first)
+	{
+		second++;
+	}
+	return line_length(bank, second) < line_length(bank, first) ? second : first;
+}
+
+// next customer for a free teller: the front of the single line or of its
+// own line, otherwise the back of the longest line. Someone must be waiting.
+static customer next_customer(des_bank *bank, int teller)
+{
+	customer next;
+	bank->waiting--;
+
+	if(SINGLE_QUEUE == bank->params.routing)
+	{
+		next = bank->customers.front();
+		bank->customers.pop();
+		return next;
+	}
+
+	std::deque<customer> *line = &bank->tellers[teller].line;
+	if(line->empty())
+	{
+		int longest = 0;
+		for(int i=1;i<bank->params.tellers;i++)
+		{
+			if(bank->tellers[i].line.size() > bank->tellers[longest].line.size())
+			{
+				longest = i;
+			}
+		}
+		line = &bank->tellers[longest].line;
+		next = line->back();
+		line->pop_back();
+		bank->stolen_customers++;
+		return next;
+	}
+
+	next = line->front();
+	line->pop_front();
+	return next;
+}
+
+// teller leaves on break, break is scheduled from when it started
+static void start_break(des_bank *bank, int teller)
+{
+	des_teller *current_teller = &bank->tellers[teller];
+
+	// waiting before the break still counts as waiting for a customer
+	if(current_teller->idle_since >= 0)
+	{
+		current_teller->idle_pending += bank->now - current_teller->idle_since;
+		current_teller->idle_since = -1;
+	}
+
+	current_teller->on_break = true;
+	current_teller->lastbreak = bank->now;
+	current_teller->breakAfter = MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+
+	sim_ticks break_length = MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_MINUTES, MAX_BREAK_MINUTES));
+	trace(bank, TRACE_BREAK_START, teller, trace_ms(break_length));
+	schedule(bank, bank->now + break_length, BREAK_END, teller);
+	schedule(bank, current_teller->lastbreak + current_teller->breakAfter, BREAK_DUE, teller);
+}
+
+// free teller decides what to do next: go on break, take the next
+// customer, wait for one, or go home if the bank is closed
+static void dispatch(des_bank *bank, int teller)
+{
+	des_teller *current_teller = &bank->tellers[teller];
+
+	if(current_teller->busy || current_teller->on_break || current_teller->finished)
+	{
+		return;
+	}
+
+	if(0 == bank->waiting && bank->BankClosed)
+	{
+		current_teller->finished = true;
+		return;
+	}
+
+	//check if time for break
+	if(bank->now >= current_teller->lastbreak + current_teller->breakAfter)
+	{
+		start_break(bank, teller);
+		return;
+	}
+
+	if(0 == bank->waiting)
+	{
+		if(current_teller->idle_since < 0)
+		{
+			current_teller->idle_since = bank->now;
+		}
+		return;
+	}
+
+	//check if teller was waiting, if yes, count and save wait time
+	if(current_teller->idle_since >= 0 || current_teller->idle_pending > 0)
+	{
+		sim_ticks wait_time = current_teller->idle_pending;
+		if(current_teller->idle_since >= 0)
+		{
+			wait_time += bank->now - current_teller->idle_since;
+		}
+		record_teller_wait(&current_teller->stats, wait_time);
+		current_teller->idle_since = -1;
+		current_teller->idle_pending = 0;
+	}
+
+	current_teller->current = next_customer(bank, teller);
+	current_teller->current.qPopTime = bank->now;
+	current_teller->busy = true;
+
+	record_queue_wait(&current_teller->stats, current_teller->current.qPopTime - current_teller->current.qPushTime);
+	trace(bank, TRACE_DEQUEUE, teller, trace_ms(current_teller->current.qPopTime - current_teller->current.qPushTime));
+	trace(bank, TRACE_SERVICE_START, teller, trace_ms(current_teller->current.serviceTime));
+
+	schedule(bank, bank->now + current_teller->current.serviceTime, SERVICE_COMPLETE, teller);
+}
+
+// customer enters the queue, or the bank closes its doors
+static void handle_arrival(des_bank *bank)
+{
+	if(bank->now >= bank->closing_time)
+	{
+		bank->BankClosed = true;
+		for(int i=0;i<bank->params.tellers;i++)
+		{
+			dispatch(bank, i);
+		}
+		return;
+	}
+
+	customer new_customer;
+	new_customer.qPushTime = bank->now;
+	new_customer.qPopTime = 0;
+	new_customer.serviceTime = next_service_time(bank);
+	new_customer.priority_class = sample_priority_class(&bank->class_random);
+	trace(bank, TRACE_ARRIVE, -1, bank->total_customers);
+
+	// the teller whose line the customer joined gets the first chance
+	int teller = 0;
+	if(SINGLE_QUEUE == bank->params.routing)
+	{
+		bank->customers.push(new_customer);
+	}
+	else
+	{
+		teller = route_customer(bank);
+		bank->tellers[teller].line.push_back(new_customer);
+	}
+
+	bank->waiting++;
+	if(bank->max_queue_size < bank->waiting)
+	{
+		bank->max_queue_size = bank->waiting;
+	}
+	bank->total_customers++;
+
+	schedule(bank, bank->now + next_arrival_gap(bank), ARRIVAL, -1);
+
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		dispatch(bank, (teller + i) % bank->params.tellers);
+	}
+}
+
+// teller finished the transaction
+static void handle_service_complete(des_bank *bank, int teller)
+{
+	des_teller *current_teller = &bank->tellers[teller];
+
+	record_transaction_time(&current_teller->stats, current_teller->current.serviceTime);
+	trace(bank, TRACE_SERVICE_END, teller, 0);
+	trace(bank, TRACE_IDLE, teller, 0);
+
+	current_teller->busy = false;
+	current_teller->idle_since = bank->now;
+	dispatch(bank, teller);
+}
+
+// break only starts right away if the teller is free, otherwise it is
+// taken as soon as the current customer is done (see dispatch)
+static void handle_break_due(des_bank *bank, int teller)
+{
+	des_teller *current_teller = &bank->tellers[teller];
+
+	// stale event, break was already taken late and rescheduled
+	if(bank->now < current_teller->lastbreak + current_teller->breakAfter)
+	{
+		return;
+	}
+	dispatch(bank, teller);
+}
+
+static void handle_break_end(des_bank *bank, int teller)
+{
+	des_teller *current_teller = &bank->tellers[teller];
+
+	current_teller->on_break = false;
+	current_teller->idle_since = bank->now;
+	trace(bank, TRACE_BREAK_END, teller, 0);
+	trace(bank, TRACE_IDLE, teller, 0);
+	dispatch(bank, teller);
+}
+
+// opens the bank with every teller waiting and the first customer at the door
+void des_init(des_bank *bank, const bank_params *params, unsigned int seed)
+{
+	bank->params = *params;
+	rng_seed(&bank->random, seed);
+	rng_batch_seed(&bank->sample_random, (uint64_t)seed << 32 | 0x5A3713);
+	rng_seed(&bank->class_random, seed ^ 0xC1A55);
+	rng_seed(&bank->route_random, seed ^ 0x2C401CE);
+	bank->arrival_next = SAMPLE_BLOCK;
+	bank->service_next = SAMPLE_BLOCK;
+	bank->now = 0;
+	bank->closing_time = BANKHOURS * TICKS_PER_HOUR;
+	bank->BankClosed = false;
+	bank->next_sequence = 0;
+
+	bank->events = calendar_queue<des_event, des_event_later>();
+	bank->customers = customer_queue(params->discipline);
+	bank->waiting = 0;
+	bank->tellers.resize(params->tellers);
+
+	bank->total_customers = 0;
+	bank->max_queue_size = 0;
+	bank->stolen_customers = 0;
+	bank->trace = NULL;
+	bank->series = NULL;
+	bank->next_sample = 0;
+
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		des_teller *current_teller = &bank->tellers[i];
+		current_teller->busy = false;
+		current_teller->on_break = false;
+		current_teller->finished = false;
+		current_teller->lastbreak = 0;
+		current_teller->breakAfter = MINUTES_TO_TICKS(rng_between(&bank->random, MIN_BREAK_INTERVAL_MINUTES, MAX_BREAK_INTERVAL_MINUTES));
+		current_teller->idle_since = 0;
+		current_teller->idle_pending = 0;
+		current_teller->line.clear();
+		teller_stats_init(&current_teller->stats);
+
+		schedule(bank, current_teller->breakAfter, BREAK_DUE, i);
+	}
+
+	schedule(bank, 0, ARRIVAL, -1);
+}
+
+// records the queue depth and what the tellers are doing
+static void sample(des_bank *bank)
+{
+	uint32_t busy_tellers = 0;
+	uint32_t tellers_on_break = 0;
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		busy_tellers += bank->tellers[i].busy ? 1 : 0;
+		tellers_on_break += bank->tellers[i].on_break ? 1 : 0;
+	}
+	series_add(bank->series, bank->waiting, busy_tellers, tellers_on_break);
+}
+
+// processes events in time order until every teller went home
+void des_run(des_bank *bank)
+{
+	des_run_until(bank, INT64_MAX);
+}
+
+// processes the events before until, returns false once every teller went
+// home. Stopping between events leaves a state that can be checkpointed.
+bool des_run_until(des_bank *bank, sim_ticks until)
+{
+	while(!bank->events.empty() && bank->events.top().time < until)
+	{
+		des_event event = bank->events.top();
+		bank->events.pop();
+
+		// nothing changes between events, so every sample due by now sees
+		// the bank as the last event left it
+		while(NULL != bank->series && bank->next_sample <= event.time)
+		{
+			sample(bank);
+			bank->next_sample += bank->series->interval;
+		}
+
+		bank->now = event.time;
+
+		switch(event.type)
+		{
+		case ARRIVAL:
+			handle_arrival(bank);
+			break;
+
+		case SERVICE_COMPLETE:
+			handle_service_complete(bank, event.teller);
+			break;
+
+		case BREAK_DUE:
+			handle_break_due(bank, event.teller);
+			break;
+
+		case BREAK_END:
+			handle_break_end(bank, event.teller);
+			break;
+		}
+	}
+	return !bank->events.empty();
+}
+
+// computes the same metrics the wall clock simulation reports
+bank_report des_report(const des_bank *bank)
+{
+	std::vector<teller_stats> tellers(bank->params.tellers);
+	for(int i=0;i<bank->params.tellers;i++)
+	{
+		tellers[i] = bank->tellers[i].stats;
+	}
+	bank_report report = build_report(&tellers[0], bank->params.tellers, bank->total_customers, bank->max_queue_size);
+	report.stolen_customers = bank->stolen_customers;
+	return report;
+}
@@ -0,0 +1,101 @@
+#ifndef _des_
+#define _des_
+
+#include <deque>
+#include <vector>
+
+#include "bank.h"
+#include "calendar_queue.h"
+#include "customer_queue.h"
+#include "rng.h"
+#include "series.h"
+#include "trace.h"
+
+// arrival gaps and transaction times are drawn this many at a time
+#define SAMPLE_BLOCK 256
+
+// Discrete event version of the bank. Instead of sleeping, the simulation
+// keeps a virtual clock (in simulated ticks) and jumps from one event to
+// the next, so a whole day is simulated in milliseconds.
+
+typedef enum
+{
+	ARRIVAL = 0,		// a new customer enters the queue
+	SERVICE_COMPLETE,	// a teller finished with its customer
+	BREAK_DUE,			// a teller's next break is due
+	BREAK_END			// a teller is back from break
+} des_event_type;
+
+typedef struct
+{
+	sim_ticks time;			// simulated time since opening
+	unsigned long sequence;	// insertion order, keeps equal times FIFO
+	des_event_type type;
+	int teller;
+} des_event;
+
+// orders the event list so that the earliest event is on top
+struct des_event_later
+{
+	bool operator()(const des_event &event1, const des_event &event2) const
+	{
+		if(event1.time != event2.time)
+		{
+			return event1.time > event2.time;
+		}
+		return event1.sequence > event2.sequence;
+	}
+};
+
+typedef struct
+{
+	bool busy;
+	bool on_break;
+	bool finished;
+	sim_ticks lastbreak;	// when the last break started
+	sim_ticks breakAfter;	// time between lastbreak and next break
+	sim_ticks idle_since;	// -1 when not waiting for a customer
+	sim_ticks idle_pending;	// waiting done before a break interrupted it
+	customer current;		// customer being serviced while busy
+	std::deque<customer> line;	// own line unless routing is SINGLE_QUEUE
+	teller_stats stats;
+} des_teller;
+
+typedef struct
+{
+	sim_ticks now;
+	sim_ticks closing_time;
+	bool BankClosed;
+	unsigned long next_sequence;
+	bank_params params;
+
+	// own random streams so banks can run in parallel
+	rng_state random;			// breaks
+	rng_batch sample_random;	// arrival gaps and transaction times
+	rng_state class_random;		// priority classes
+	rng_state route_random;		// power of two choices
+	sim_ticks arrival_samples[SAMPLE_BLOCK];
+	size_t arrival_next;
+	sim_ticks service_samples[SAMPLE_BLOCK];
+	size_t service_next;
+
+	calendar_queue<des_event, des_event_later> events;
+	customer_queue customers;	// the single line
+	unsigned int waiting;		// customers in every line together
+	std::vector<des_teller> tellers;
+
+	unsigned int total_customers;
+	unsigned int max_queue_size;
+	unsigned int stolen_customers;
+
+	trace_buffer *trace;		// NULL unless events are traced
+	time_series *series;		// NULL unless the day is sampled
+	sim_ticks next_sample;
+} des_bank;
+
+void des_init(des_bank *bank, const bank_params *params, unsigned int seed);
+void des_run(des_bank *bank);
+bool des_run_until(des_bank *bank, sim_ticks until);
+bank_report des_report(const des_bank *bank);
+
+#endif
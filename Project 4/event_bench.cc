@@ -0,0 +1,81 @@
+// Compares the calendar queue event list against std::priority_queue with
+// the classic hold model: the list is filled with a number of pending
+// events, then every operation pops the earliest event and schedules a
+// new one a random (exponential) time after it, so the size stays put.
+//
+// usage: event_bench [operations]
+
+#include <queue>
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+#include <time.h>
+
+#include "calendar_queue.h"
+#include "des.h"
+#include "rng.h"
+
+#define DEFAULT_HOLD_OPERATIONS 2000000
+
+// mean time between an event and the one it schedules
+#define HOLD_MEAN_SECONDS 3600
+
+// returns hold operations per second with the given number of pending events
+template <typename Q>
+double run(unsigned long pending, unsigned long operations)
+{
+	Q *events = new Q;
+	rng_state random;
+	des_event event;
+	unsigned long sequence = 0;
+	struct timespec start, end;
+
+	rng_seed(&random, 1);
+	event.type = ARRIVAL;
+	event.teller = 0;
+	for(unsigned long i=0;i<pending;i++)
+	{
+		event.time = seconds_to_ticks(rng_exponential(&random, HOLD_MEAN_SECONDS));
+		event.sequence = sequence++;
+		events->push(event);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(unsigned long i=0;i<operations;i++)
+	{
+		event = events->top();
+		events->pop();
+		event.time += seconds_to_ticks(rng_exponential(&random, HOLD_MEAN_SECONDS));
+		event.sequence = sequence++;
+		events->push(event);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	delete events;
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return operations / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long pending_counts[] = {1000, 10000, 100000, 1000000, 10000000};
+	unsigned long operations = DEFAULT_HOLD_OPERATIONS;
+
+	if(argc > 1)
+	{
+		operations = strtoul(argv[1], NULL, 10);
+	}
+
+	std::cout << "pending_events,event_list,operations_per_second" << std::endl;
+	for(unsigned int i=0;i<sizeof(pending_counts)/sizeof(pending_counts[0]);i++)
+	{
+		double rate = run< std::priority_queue<des_event, std::vector<des_event>, des_event_later> >(pending_counts[i], operations);
+		std::cout << pending_counts[i] << ",binary_heap," << rate << std::endl;
+
+		rate = run< calendar_queue<des_event, des_event_later> >(pending_counts[i], operations);
+		std::cout << pending_counts[i] << ",calendar," << rate << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include <math.h>
+#include <string.h>
+
+#include "histogram.h"
+
+static inline int index_for(uint64_t value)
+{
+	if(value < HISTOGRAM_SUB_BUCKETS)
+	{
+		return (int)value;
+	}
+
+	int exponent = 63 - __builtin_clzll(value);
+	if(exponent >= HISTOGRAM_MAX_EXPONENT)
+	{
+		return HISTOGRAM_COUNTS - 1;
+	}
+
+	// top HISTOGRAM_SUB_BUCKET_BITS bits of the value, in [half, full)
+	int shift = exponent - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+	int sub_bucket = (int)(value >> shift);
+	return HISTOGRAM_SUB_BUCKETS + (exponent - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_HALF_SUB_BUCKETS + (sub_bucket - HISTOGRAM_HALF_SUB_BUCKETS);
+}
+
+// largest value that lands in the same bucket as index
+static uint64_t highest_value_for(int index)
+{
+	if(index < HISTOGRAM_SUB_BUCKETS)
+	{
+		return index;
+	}
+
+	int above = index - HISTOGRAM_SUB_BUCKETS;
+	int exponent = HISTOGRAM_SUB_BUCKET_BITS + above / HISTOGRAM_HALF_SUB_BUCKETS;
+	uint64_t sub_bucket = HISTOGRAM_HALF_SUB_BUCKETS + above % HISTOGRAM_HALF_SUB_BUCKETS;
+	int shift = exponent - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+	return ((sub_bucket + 1) << shift) - 1;
+}
+
+void histogram_init(histogram *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+}
+
+void histogram_record(histogram *hist, uint64_t value)
+{
+	hist->counts[index_for(value)]++;
+	hist->total++;
+}
+
+void histogram_merge(histogram *hist, const histogram *other)
+{
+	for(int i=0;i<HISTOGRAM_COUNTS;i++)
+	{
+		hist->counts[i] += other->counts[i];
+	}
+	hist->total += other->total;
+}
+
+// value at or below which the given percentage (0 to 100) of recorded
+// values lie, reported as the top of its bucket like HdrHistogram does
+uint64_t histogram_percentile(const histogram *hist, double percentile)
+{
+	if(0 == hist->total)
+	{
+		return 0;
+	}
+
+	uint64_t rank = (uint64_t)ceil(percentile / 100.0 * hist->total);
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for(int i=0;i<HISTOGRAM_COUNTS;i++)
+	{
+		seen += hist->counts[i];
+		if(seen >= rank)
+		{
+			return highest_value_for(i);
+		}
+	}
+	return highest_value_for(HISTOGRAM_COUNTS - 1);
+}
@@ -0,0 +1,36 @@
+#ifndef _histogram_
+#define _histogram_
+
+#include <stdint.h>
+
+// HDR style log-linear histogram of non negative integer values.
+//
+// Values below HISTOGRAM_SUB_BUCKETS get a bucket each. Above that every
+// power of two is split into HISTOGRAM_SUB_BUCKETS / 2 equal buckets, so
+// the bucket a value falls in is never wider than 1/64 of the value
+// (better than 2 significant digits). Finding the bucket is a count
+// leading zeros and a shift, and the counts array has a fixed size, so
+// recording is constant time and the memory never grows.
+//
+// Each thread records into its own histogram; merging is adding counts.
+
+#define HISTOGRAM_SUB_BUCKET_BITS 7
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_SUB_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+
+// values of 2^HISTOGRAM_MAX_EXPONENT and above are counted in the last bucket
+#define HISTOGRAM_MAX_EXPONENT 40
+#define HISTOGRAM_COUNTS (HISTOGRAM_SUB_BUCKETS + (HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_HALF_SUB_BUCKETS)
+
+typedef struct
+{
+	uint64_t total;
+	uint64_t counts[HISTOGRAM_COUNTS];
+} histogram;
+
+void histogram_init(histogram *hist);
+void histogram_record(histogram *hist, uint64_t value);
+void histogram_merge(histogram *hist, const histogram *other);
+uint64_t histogram_percentile(const histogram *hist, double percentile);
+
+#endif
@@ -0,0 +1,122 @@
+#include <new>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "live.h"
+
+static const char *state_names[] = {"idle", "busy", "break", "gone"};
+
+// creates (or takes over) the shared memory object and maps it, NULL if
+// it cannot be created
+live_block *live_create(const char *name)
+{
+	int descriptor = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if(-1 == descriptor)
+	{
+		return NULL;
+	}
+	if(-1 == ftruncate(descriptor, sizeof(live_block)))
+	{
+		close(descriptor);
+		return NULL;
+	}
+
+	void *memory = mmap(NULL, sizeof(live_block), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if(MAP_FAILED == memory)
+	{
+		return NULL;
+	}
+
+	live_block *block = new(memory) live_block;
+	block->sequence.store(0, std::memory_order_relaxed);
+	memset(&block->metrics, 0, sizeof(block->metrics));
+	block->version = LIVE_VERSION;
+	block->size = sizeof(live_block);
+	block->ticks_per_second = TICKS_PER_SECOND;
+	// the magic goes last so a reader never sees a half built header
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(block->magic, LIVE_MAGIC, sizeof(block->magic));
+	return block;
+}
+
+// only one thread may publish into a block
+void live_publish(live_block *block, const live_metrics *metrics)
+{
+	uint64_t sequence = block->sequence.load(std::memory_order_relaxed);
+	block->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&block->metrics, metrics, sizeof(live_metrics));
+	block->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// unmaps the block and removes its name, readers that mapped it keep it
+void live_destroy(live_block *block, const char *name)
+{
+	munmap(block, sizeof(live_block));
+	shm_unlink(name);
+}
+
+// maps a block read only, NULL if there is none or it is not a live block
+// of this version
+const live_block *live_attach(const char *name)
+{
+	int descriptor = shm_open(name, O_RDONLY, 0);
+	if(-1 == descriptor)
+	{
+		return NULL;
+	}
+
+	struct stat info;
+	if(-1 == fstat(descriptor, &info) || info.st_size < (off_t)sizeof(live_block))
+	{
+		close(descriptor);
+		return NULL;
+	}
+
+	void *memory = mmap(NULL, sizeof(live_block), PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if(MAP_FAILED == memory)
+	{
+		return NULL;
+	}
+
+	const live_block *block = (const live_block *)memory;
+	if(0 != memcmp(block->magic, LIVE_MAGIC, sizeof(block->magic)) || LIVE_VERSION != block->version || sizeof(live_block) != block->size)
+	{
+		munmap(memory, sizeof(live_block));
+		return NULL;
+	}
+	return block;
+}
+
+// copies a consistent snapshot of the metrics, only reads memory
+void live_read(const live_block *block, live_metrics *metrics)
+{
+	while(1)
+	{
+		uint64_t before = block->sequence.load(std::memory_order_acquire);
+		if(0 == (before & 1))
+		{
+			memcpy(metrics, (const void *)&block->metrics, sizeof(live_metrics));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(before == block->sequence.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
+	}
+}
+
+void live_detach(const live_block *block)
+{
+	munmap((void *)block, sizeof(live_block));
+}
+
+const char *live_state_name(int state)
+{
+	return state >= LIVE_IDLE && state <= LIVE_GONE ? state_names[state] : "unknown";
+}
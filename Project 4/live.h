@@ -0,0 +1,71 @@
+#ifndef _live_
+#define _live_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "mpmc_queue.h"
+#include "sim_time.h"
+
+// Live metrics of a running wall clock simulation in POSIX shared memory.
+//
+// The bank's sampler thread is the only writer: every simulated minute it
+// builds a live_metrics from the atomics the tellers already keep and
+// copies it into the block under a sequence lock. The sequence is odd
+// while a copy is in progress, so a reader copies the metrics out, checks
+// the sequence did not change and was even, and tries again otherwise.
+// Readers never write to the block and never make a system call after
+// mapping it, and the tellers never touch it at all. monitor.cc prints a
+// running bank's block.
+
+#define LIVE_MAGIC "BANKLIVE"
+#define LIVE_VERSION 1
+#define LIVE_DEFAULT_NAME "/bank_live"
+
+// tellers beyond this are counted but not shown one by one
+#define LIVE_MAX_TELLERS 64
+
+typedef enum
+{
+	LIVE_IDLE = 0,
+	LIVE_BUSY,
+	LIVE_ON_BREAK,
+	LIVE_GONE		// the bank closed and the teller went home
+} live_teller_state;
+
+typedef struct
+{
+	int64_t now;				// simulated ticks since the bank opened
+	uint32_t closed;			// 1 once every teller went home
+	uint32_t tellers;
+	uint32_t queue_depth;
+	uint32_t arrived;			// customers so far
+	uint32_t served;
+	uint32_t busy_tellers;
+	uint32_t tellers_on_break;
+	uint32_t padding;
+	double average_wait;		// seconds, of the customers served so far
+	double average_transaction_time;
+	uint8_t teller_state[LIVE_MAX_TELLERS];
+	uint32_t teller_served[LIVE_MAX_TELLERS];
+} live_metrics;
+
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t size;				// sizeof(live_block) of the writer
+	int64_t ticks_per_second;
+	alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> sequence;
+	live_metrics metrics;
+} live_block;
+
+live_block *live_create(const char *name);
+void live_publish(live_block *block, const live_metrics *metrics);
+void live_destroy(live_block *block, const char *name);
+const live_block *live_attach(const char *name);
+void live_read(const live_block *block, live_metrics *metrics);
+void live_detach(const live_block *block);
+const char *live_state_name(int state);
+
+#endif
@@ -0,0 +1,358 @@
+// Microbenchmarks of the simulation's hot paths, to catch regressions as
+// the engine changes:
+//   queue            customers through the lock-free customer queue with
+//                    1 to -t producers and 1 to -t consumers
+//   create_customer  drawing a customer for the wall clock simulation
+//   seconds_to_ticks, ticks_to_seconds, simulated_to_real_ns,
+//   real_ns_to_simulated, ns_to_timespec, real_clock_ns
+//                    the time conversions
+//   des_events       events processed per second by the virtual time
+//                    simulation, for each queue discipline and routing
+// Every benchmark runs -r times and the fastest run is reported, as CSV:
+// benchmark,parameter,operations,seconds,operations_per_second,ns_per_operation
+//
+// usage: micro_bench [-n operations] [-t threads] [-r repeats]
+
+#include <iostream>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bank.h"
+#include "des.h"
+#include "mpmc_queue.h"
+#include "rng.h"
+#include "sim_time.h"
+
+#define DEFAULT_MICRO_OPERATIONS 10000000
+#define DEFAULT_MICRO_THREADS 4
+#define DEFAULT_MICRO_REPEATS 3
+
+// simulated days per des_events run
+#define MICRO_DES_DAYS 200
+
+// results go here so the compiler cannot drop the loops
+volatile int64_t sink;
+
+static double now_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void print_row(const char *benchmark, const char *parameter, unsigned long operations, double seconds)
+{
+	std::cout << benchmark << "," << parameter << "," << operations << "," << seconds << ","
+			<< operations / seconds << "," << seconds * 1e9 / operations << std::endl;
+}
+
+// shared by the producers and consumers of one queue run
+typedef struct
+{
+	mpmc_queue<customer, CUSTOMER_QUEUE_CAPACITY> queue;
+	unsigned long per_producer;
+	std::atomic<unsigned long> remaining;	// customers not yet popped
+	std::atomic<bool> go;
+} queue_run;
+
+static void *producer(void *argument)
+{
+	queue_run *run = (queue_run *)argument;
+	customer data;
+	data.qPopTime = 0;
+	data.serviceTime = 0;
+	data.priority_class = 0;
+
+	while(!run->go.load(std::memory_order_acquire))
+	{
+		sched_yield();
+	}
+	for(unsigned long i=0;i<run->per_producer;i++)
+	{
+		data.qPushTime = i;
+		while(!run->queue.push(data))
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void *consumer(void *argument)
+{
+	queue_run *run = (queue_run *)argument;
+	customer data;
+	int64_t sum = 0;
+
+	while(!run->go.load(std::memory_order_acquire))
+	{
+		sched_yield();
+	}
+	while(run->remaining.load(std::memory_order_relaxed) > 0)
+	{
+		if(run->queue.pop(data))
+		{
+			sum += data.qPushTime;
+			run->remaining.fetch_sub(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+	sink = sum;
+	return NULL;
+}
+
+// seconds to move producers * per_producer customers through the queue
+static double time_queue(int producers, int consumers, unsigned long per_producer)
+{
+	queue_run *run = new queue_run;
+	pthread_t *threads = new pthread_t[producers + consumers];
+
+	run->per_producer = per_producer;
+	run->remaining.store(producers * per_producer);
+	run->go.store(false);
+	for(int i=0;i<producers;i++)
+	{
+		pthread_create(&threads[i], NULL, &producer, run);
+	}
+	for(int i=0;i<consumers;i++)
+	{
+		pthread_create(&threads[producers + i], NULL, &consumer, run);
+	}
+
+	double start = now_seconds();
+	run->go.store(true, std::memory_order_release);
+	for(int i=0;i<producers+consumers;i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	double seconds = now_seconds() - start;
+
+	delete[] threads;
+	delete run;
+	return seconds;
+}
+
+static double time_create_customer(unsigned long operations)
+{
+	bank_params params;
+	rng_state random;
+	int64_t sum = 0;
+
+	default_bank_params(&params);
+	rng_seed(&random, 1);
+	double start = now_seconds();
+	for(unsigned long i=0;i<operations;i++)
+	{
+		sum += create_customer(&params, i, &random).serviceTime;
+	}
+	double seconds = now_seconds() - start;
+	sink = sum;
+	return seconds;
+}
+
+typedef enum
+{
+	SECONDS_TO_TICKS_BENCH = 0,
+	TICKS_TO_SECONDS_BENCH,
+	SIMULATED_TO_REAL_BENCH,
+	REAL_TO_SIMULATED_BENCH,
+	NS_TO_TIMESPEC_BENCH,
+	REAL_CLOCK_BENCH
+} conversion;
+
+#define NUMBER_OF_CONVERSIONS 6
+
+static const char *conversion_names[NUMBER_OF_CONVERSIONS] =
+{
+	"seconds_to_ticks", "ticks_to_seconds", "simulated_to_real_ns",
+	"real_ns_to_simulated", "ns_to_timespec", "real_clock_ns"
+};
+
+// every call gets a different argument so none can be hoisted
+static double time_conversion(conversion kind, unsigned long operations)
+{
+	int64_t sum = 0;
+	double total = 0;
+
+	double start = now_seconds();
+	switch(kind)
+	{
+	case SECONDS_TO_TICKS_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			sum += seconds_to_ticks(i * 0.001);
+		}
+		break;
+
+	case TICKS_TO_SECONDS_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			total += ticks_to_seconds(i * 1000003);
+		}
+		break;
+
+	case SIMULATED_TO_REAL_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			sum += simulated_to_real_ns(i * 1000003);
+		}
+		break;
+
+	case REAL_TO_SIMULATED_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			sum += real_ns_to_simulated(i * 1000003);
+		}
+		break;
+
+	case NS_TO_TIMESPEC_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			sum += ns_to_timespec(i * 1000003).tv_nsec;
+		}
+		break;
+
+	case REAL_CLOCK_BENCH:
+		for(unsigned long i=0;i<operations;i++)
+		{
+			sum += real_clock_ns();
+		}
+		break;
+	}
+	double seconds = now_seconds() - start;
+	sink = sum + (int64_t)total;
+	return seconds;
+}
+
+// seconds to simulate MICRO_DES_DAYS days, *events gets the events processed
+static double time_des(const bank_params *params, unsigned long *events)
+{
+	*events = 0;
+	double start = now_seconds();
+	for(unsigned int i=0;i<MICRO_DES_DAYS;i++)
+	{
+		des_bank *bank = new des_bank;
+		des_init(bank, params, i + 1);
+		des_run(bank);
+		// every scheduled event got a sequence number and none is left
+		*events += bank->next_sequence;
+		delete bank;
+	}
+	return now_seconds() - start;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long operations = DEFAULT_MICRO_OPERATIONS;
+	int max_threads = DEFAULT_MICRO_THREADS;
+	int repeats = DEFAULT_MICRO_REPEATS;
+	int option;
+
+	while((option = getopt(argc, argv, "n:t:r:")) != -1)
+	{
+		switch(option)
+		{
+		case 'n':
+			operations = strtoul(optarg, NULL, 10);
+			break;
+
+		case 't':
+			max_threads = atoi(optarg);
+			break;
+
+		case 'r':
+			repeats = atoi(optarg);
+			break;
+
+		default:
+			std::cerr << "usage: " << argv[0] << " [-n operations] [-t threads] [-r repeats]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if(0 == operations || max_threads < 1 || repeats < 1)
+	{
+		std::cerr << "operations, threads and repeats must be positive" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "benchmark,parameter,operations,seconds,operations_per_second,ns_per_operation" << std::endl;
+
+	// producers x consumers, powers of two up to -t
+	for(int producers=1;producers<=max_threads;producers*=2)
+	{
+		for(int consumers=1;consumers<=max_threads;consumers*=2)
+		{
+			unsigned long per_producer = operations / 10 / producers;
+			if(0 == per_producer)
+			{
+				// a small -n still moves a customer per producer
+				per_producer = 1;
+			}
+			double best = 0;
+			for(int i=0;i<repeats;i++)
+			{
+				double seconds = time_queue(producers, consumers, per_producer);
+				best = 0 == i || seconds < best ? seconds : best;
+			}
+			char parameter[32];
+			snprintf(parameter, sizeof(parameter), "%dp%dc", producers, consumers);
+			print_row("queue", parameter, per_producer * producers, best);
+		}
+	}
+
+	double best = 0;
+	for(int i=0;i<repeats;i++)
+	{
+		double seconds = time_create_customer(operations);
+		best = 0 == i || seconds < best ? seconds : best;
+	}
+	print_row("create_customer", "uniform", operations, best);
+
+	for(int kind=0;kind<NUMBER_OF_CONVERSIONS;kind++)
+	{
+		best = 0;
+		for(int i=0;i<repeats;i++)
+		{
+			double seconds = time_conversion((conversion)kind, operations);
+			best = 0 == i || seconds < best ? seconds : best;
+		}
+		print_row(conversion_names[kind], "", operations, best);
+	}
+
+	// one row per queue discipline and one per routing of a line per teller
+	for(int variant=0;variant<NUMBER_OF_DISCIPLINES+NUMBER_OF_ROUTINGS-1;variant++)
+	{
+		bank_params params;
+		default_bank_params(&params);
+		const char *name;
+		if(variant < NUMBER_OF_DISCIPLINES)
+		{
+			params.discipline = (queue_discipline)variant;
+			name = discipline_name(params.discipline);
+		}
+		else
+		{
+			params.routing = (queue_routing)(variant - NUMBER_OF_DISCIPLINES + 1);
+			name = routing_name(params.routing);
+		}
+
+		unsigned long events = 0;
+		best = 0;
+		for(int i=0;i<repeats;i++)
+		{
+			double seconds = time_des(&params, &events);
+			best = 0 == i || seconds < best ? seconds : best;
+		}
+		print_row("des_events", name, events, best);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+// Prints the live metrics of a running wall clock bank (bank -L name) once
+// per interval until the bank closes. The block is mapped once, after that
+// every snapshot is read straight from shared memory.
+//
+// usage: monitor [-i ms] [name]
+//   -i    real milliseconds between lines, 500 by default
+//   name  shared memory object the bank publishes to, /bank_live by default
+
+#include <iostream>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "live.h"
+
+#define DEFAULT_MONITOR_INTERVAL_MS 500
+
+int main(int argc, char *argv[])
+{
+	const char *name = LIVE_DEFAULT_NAME;
+	long interval_ms = DEFAULT_MONITOR_INTERVAL_MS;
+	int option;
+
+	while((option = getopt(argc, argv, "i:")) != -1)
+	{
+		switch(option)
+		{
+		case 'i':
+			interval_ms = strtol(optarg, NULL, 10);
+			break;
+
+		default:
+			std::cerr << "usage: " << argv[0] << " [-i ms] [name]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if(optind < argc)
+	{
+		name = argv[optind];
+	}
+
+	const live_block *block = live_attach(name);
+	if(NULL == block)
+	{
+		std::cerr << "no live metrics at " << name << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	struct timespec pause;
+	pause.tv_sec = interval_ms / 1000;
+	pause.tv_nsec = (interval_ms % 1000) * 1000000;
+
+	live_metrics metrics;
+	do
+	{
+		live_read(block, &metrics);
+
+		long minutes = metrics.now / TICKS_PER_MINUTE;
+		std::cout << minutes / 60 << ":" << (minutes % 60 < 10 ? "0" : "") << minutes % 60
+				<< " queue " << metrics.queue_depth
+				<< " arrived " << metrics.arrived
+				<< " served " << metrics.served
+				<< " busy " << metrics.busy_tellers
+				<< " break " << metrics.tellers_on_break
+				<< " wait " << metrics.average_wait << " s"
+				<< " transaction " << metrics.average_transaction_time << " s |";
+		for(unsigned int i=0;i<metrics.tellers && i<LIVE_MAX_TELLERS;i++)
+		{
+			std::cout << " " << live_state_name(metrics.teller_state[i]) << "/" << metrics.teller_served[i];
+		}
+		std::cout << std::endl;
+
+		if(0 == metrics.closed)
+		{
+			nanosleep(&pause, NULL);
+		}
+	} while(0 == metrics.closed);
+
+	live_detach(block);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+#ifndef _mpmc_queue_
+#define _mpmc_queue_
+
+#include <atomic>
+#include <stddef.h>
+
+// Bounded lock-free multi producer / multi consumer queue.
+//
+// Every cell carries a sequence number telling whether it is ready to be
+// written (sequence == position) or read (sequence == position + 1), so
+// producers and consumers only ever race on their own position counter
+// with a single compare and swap. CAPACITY must be a power of two.
+//
+// The queue also keeps its current depth and the highest depth it ever
+// reached, so callers do not need a lock to track the maximum queue size,
+// and counts lost races to show how contended it is.
+
+#define CACHE_LINE_SIZE 64
+
+template <typename T, size_t CAPACITY>
+class mpmc_queue
+{
+public:
+	mpmc_queue()
+	{
+		static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+		for(size_t i=0;i<CAPACITY;i++)
+		{
+			buffer[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		enqueue_position.store(0, std::memory_order_relaxed);
+		dequeue_position.store(0, std::memory_order_relaxed);
+		depth.store(0, std::memory_order_relaxed);
+		max_depth.store(0, std::memory_order_relaxed);
+		retries.store(0, std::memory_order_relaxed);
+	}
+
+	// returns false if the queue is full
+	bool push(const T &data)
+	{
+		cell *current_cell;
+		size_t position = enqueue_position.load(std::memory_order_relaxed);
+		while(1)
+		{
+			current_cell = &buffer[position & (CAPACITY - 1)];
+			size_t sequence = current_cell->sequence.load(std::memory_order_acquire);
+			long difference = (long)sequence - (long)position;
+			if(0 == difference)
+			{
+				if(enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+				retries.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if(difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				retries.fetch_add(1, std::memory_order_relaxed);
+				position = enqueue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		current_cell->data = data;
+		current_cell->sequence.store(position + 1, std::memory_order_release);
+
+		// update high water mark
+		long new_depth = depth.fetch_add(1, std::memory_order_relaxed) + 1;
+		long current_max = max_depth.load(std::memory_order_relaxed);
+		while(new_depth > current_max && !max_depth.compare_exchange_weak(current_max, new_depth, std::memory_order_relaxed))
+		{
+		}
+		return true;
+	}
+
+	// returns false if the queue is empty
+	bool pop(T &data)
+	{
+		cell *current_cell;
+		size_t position = dequeue_position.load(std::memory_order_relaxed);
+		while(1)
+		{
+			current_cell = &buffer[position & (CAPACITY - 1)];
+			size_t sequence = current_cell->sequence.load(std::memory_order_acquire);
+			long difference = (long)sequence - (long)(position + 1);
+			if(0 == difference)
+			{
+				if(dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+				retries.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if(difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				retries.fetch_add(1, std::memory_order_relaxed);
+				position = dequeue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		data = current_cell->data;
+		current_cell->sequence.store(position + CAPACITY, std::memory_order_release);
+		depth.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// number of elements, only a snapshot while other threads are running
+	long size() const
+	{
+		long current_depth = depth.load(std::memory_order_relaxed);
+		return current_depth < 0 ? 0 : current_depth;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// highest depth the queue reached
+	long max_size() const
+	{
+		return max_depth.load(std::memory_order_relaxed);
+	}
+
+	// times a push or pop lost a race to another thread and had to retry
+	unsigned long contended() const
+	{
+		return retries.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	alignas(CACHE_LINE_SIZE) cell buffer[CAPACITY];
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_position;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_position;
+	alignas(CACHE_LINE_SIZE) std::atomic<long> depth;
+	std::atomic<long> max_depth;
+	std::atomic<unsigned long> retries;
+};
+
+#endif
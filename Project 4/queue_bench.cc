@@ -0,0 +1,427 @@
+// Compares the lock-free customer queue against the std::queue + mutex
+// queue the simulation used before, with one customer generator, a
+// number of teller threads and one thread collecting served customers.
+// Also runs a line per teller (steal_queue.h), the generator picking the
+// shortest line (jsq) or the shorter of two random ones (p2c) and idle
+// tellers stealing from the back of the longest line (of two with p2c).
+// contended counts how often a thread had to wait for or retry against
+// another one.
+//
+// usage: queue_bench [customers]
+
+#include <queue>
+#include <iostream>
+#include <atomic>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "bank.h"
+#include "mpmc_queue.h"
+#include "rng.h"
+#include "steal_queue.h"
+
+#define DEFAULT_BENCH_CUSTOMERS 200000
+
+// the queue as it was: std::queue guarded by a global mutex
+template <typename T>
+class mutex_queue
+{
+public:
+	mutex_queue() : max_depth(0), collisions(0)
+	{
+		pthread_mutex_init(&queue_semaphore, NULL);
+	}
+
+	~mutex_queue()
+	{
+		pthread_mutex_destroy(&queue_semaphore);
+	}
+
+	bool push(const T &data)
+	{
+		lock();
+		elements.push(data);
+		if(max_depth < (long)elements.size())
+		{
+			max_depth = elements.size();
+		}
+		pthread_mutex_unlock(&queue_semaphore);
+		return true;
+	}
+
+	bool pop(T &data)
+	{
+		bool hasElement = false;
+		lock();
+		if(!elements.empty())
+		{
+			data = elements.front();
+			elements.pop();
+			hasElement = true;
+		}
+		pthread_mutex_unlock(&queue_semaphore);
+		return hasElement;
+	}
+
+	long max_size() const
+	{
+		return max_depth;
+	}
+
+	unsigned long contended() const
+	{
+		return collisions;
+	}
+
+private:
+	// counts the times the mutex was already taken (under the mutex)
+	void lock()
+	{
+		if(0 == pthread_mutex_trylock(&queue_semaphore))
+		{
+			return;
+		}
+		pthread_mutex_lock(&queue_semaphore);
+		collisions++;
+	}
+
+	pthread_mutex_t queue_semaphore;
+	std::queue<T> elements;
+	long max_depth;
+	unsigned long collisions;
+};
+
+template <typename Q>
+struct bench
+{
+	Q customers;
+	Q previousCustomers;
+	unsigned long total;
+	std::atomic<unsigned long> collected;
+	std::atomic<bool> done;
+};
+
+template <typename Q>
+void *generator(void *argument)
+{
+	bench<Q> *current = (bench<Q> *)argument;
+	customer new_customer;
+	new_customer.qPushTime = 0;
+	new_customer.qPopTime = 0;
+	for(unsigned long i=0;i<current->total;i++)
+	{
+		new_customer.serviceTime = i;
+		while(!current->customers.push(new_customer))
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+template <typename Q>
+void *teller(void *argument)
+{
+	bench<Q> *current = (bench<Q> *)argument;
+	customer current_customer;
+	while(!current->done.load(std::memory_order_relaxed))
+	{
+		if(current->customers.pop(current_customer))
+		{
+			while(!current->previousCustomers.push(current_customer))
+			{
+				sched_yield();
+			}
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+template <typename Q>
+void *collector(void *argument)
+{
+	bench<Q> *current = (bench<Q> *)argument;
+	customer served_customer;
+	while(current->collected.load(std::memory_order_relaxed) < current->total)
+	{
+		if(current->previousCustomers.pop(served_customer))
+		{
+			current->collected.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+	current->done.store(true);
+	return NULL;
+}
+
+// returns customers moved through both queues per second
+template <typename Q>
+double run(int tellers, unsigned long total, long *max_depth, unsigned long *contended)
+{
+	bench<Q> *current = new bench<Q>;
+	current->total = total;
+	current->collected.store(0);
+	current->done.store(false);
+
+	pthread_t generator_thread, collector_thread;
+	pthread_t *teller_threads = new pthread_t[tellers];
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int i=0;i<tellers;i++)
+	{
+		pthread_create(&teller_threads[i], NULL, &teller<Q>, current);
+	}
+	pthread_create(&collector_thread, NULL, &collector<Q>, current);
+	pthread_create(&generator_thread, NULL, &generator<Q>, current);
+
+	pthread_join(generator_thread, NULL);
+	pthread_join(collector_thread, NULL);
+	for(int i=0;i<tellers;i++)
+	{
+		pthread_join(teller_threads[i], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	*max_depth = current->customers.max_size();
+	*contended = current->customers.contended();
+	delete[] teller_threads;
+	delete current;
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return total / seconds;
+}
+
+typedef steal_queue<customer, CUSTOMER_QUEUE_CAPACITY> line;
+
+// the same with a line per teller
+typedef struct
+{
+	line *lines;
+	int tellers;
+	bool power_of_two;		// p2c, otherwise join the shortest line
+	mpmc_queue<customer, CUSTOMER_QUEUE_CAPACITY> previousCustomers;
+	unsigned long total;
+	std::atomic<unsigned long> collected;
+	std::atomic<bool> done;
+} lines_bench;
+
+typedef struct
+{
+	lines_bench *bench;
+	int teller;
+} lines_teller;
+
+// two different random lines for p2c, picked the way des.cc does
+static void two_lines(lines_bench *current, rng_state *random, int *first, int *second)
+{
+	*first = rng_between(random, 0, current->tellers - 1);
+	*second = rng_between(random, 0, current->tellers - 2);
+	if(*second >= *first)
+	{
+		(*second)++;
+	}
+}
+
+// line a new customer joins
+static int route(lines_bench *current, rng_state *random)
+{
+	if(current->power_of_two && current->tellers > 1)
+	{
+		int first, second;
+		two_lines(current, random, &first, &second);
+		return current->lines[second].size() < current->lines[first].size() ? second : first;
+	}
+
+	int shortest = 0;
+	for(int i=1;i<current->tellers;i++)
+	{
+		if(current->lines[i].size() < current->lines[shortest].size())
+		{
+			shortest = i;
+		}
+	}
+	return shortest;
+}
+
+// line an idle teller steals from: the longest one, or with p2c the
+// longer of two random ones so a steal does not look at every line
+static int victim(lines_bench *current, rng_state *random)
+{
+	if(current->power_of_two && current->tellers > 1)
+	{
+		int first, second;
+		two_lines(current, random, &first, &second);
+		return current->lines[second].size() > current->lines[first].size() ? second : first;
+	}
+
+	int longest = 0;
+	for(int i=1;i<current->tellers;i++)
+	{
+		if(current->lines[i].size() > current->lines[longest].size())
+		{
+			longest = i;
+		}
+	}
+	return longest;
+}
+
+void *lines_generator(void *argument)
+{
+	lines_bench *current = (lines_bench *)argument;
+	customer new_customer;
+	rng_state random;
+	rng_seed(&random, 1);
+	new_customer.qPushTime = 0;
+	new_customer.qPopTime = 0;
+	for(unsigned long i=0;i<current->total;i++)
+	{
+		new_customer.serviceTime = i;
+		while(!current->lines[route(current, &random)].push(new_customer))
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+void *lines_teller_thread(void *argument)
+{
+	lines_teller *self = (lines_teller *)argument;
+	lines_bench *current = self->bench;
+	customer current_customer;
+	rng_state random;
+	rng_seed(&random, self->teller + 2);
+	while(!current->done.load(std::memory_order_relaxed))
+	{
+		bool hasCustomer = current->lines[self->teller].pop(current_customer);
+		if(!hasCustomer)
+		{
+			hasCustomer = current->lines[victim(current, &random)].steal(current_customer);
+		}
+
+		if(hasCustomer)
+		{
+			while(!current->previousCustomers.push(current_customer))
+			{
+				sched_yield();
+			}
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+void *lines_collector(void *argument)
+{
+	lines_bench *current = (lines_bench *)argument;
+	customer served_customer;
+	while(current->collected.load(std::memory_order_relaxed) < current->total)
+	{
+		if(current->previousCustomers.pop(served_customer))
+		{
+			current->collected.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+	current->done.store(true);
+	return NULL;
+}
+
+double run_lines(int tellers, bool power_of_two, unsigned long total, long *max_depth, unsigned long *contended)
+{
+	lines_bench *current = new lines_bench;
+	current->lines = new line[tellers];
+	current->tellers = tellers;
+	current->power_of_two = power_of_two;
+	current->total = total;
+	current->collected.store(0);
+	current->done.store(false);
+
+	pthread_t generator_thread, collector_thread;
+	pthread_t *teller_threads = new pthread_t[tellers];
+	lines_teller *teller_arguments = new lines_teller[tellers];
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int i=0;i<tellers;i++)
+	{
+		teller_arguments[i].bench = current;
+		teller_arguments[i].teller = i;
+		pthread_create(&teller_threads[i], NULL, &lines_teller_thread, &teller_arguments[i]);
+	}
+	pthread_create(&collector_thread, NULL, &lines_collector, current);
+	pthread_create(&generator_thread, NULL, &lines_generator, current);
+
+	pthread_join(generator_thread, NULL);
+	pthread_join(collector_thread, NULL);
+	for(int i=0;i<tellers;i++)
+	{
+		pthread_join(teller_threads[i], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	*max_depth = 0;
+	*contended = 0;
+	for(int i=0;i<tellers;i++)
+	{
+		if(*max_depth < current->lines[i].max_size())
+		{
+			*max_depth = current->lines[i].max_size();
+		}
+		*contended += current->lines[i].contended();
+	}
+	delete[] teller_arguments;
+	delete[] teller_threads;
+	delete[] current->lines;
+	delete current;
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return total / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+	int teller_counts[] = {3, 32, 256};
+	unsigned long total = DEFAULT_BENCH_CUSTOMERS;
+	long max_depth;
+	unsigned long contended;
+
+	if(argc > 1)
+	{
+		total = strtoul(argv[1], NULL, 10);
+	}
+
+	std::cout << "tellers,queue,customers_per_second,max_depth,contended" << std::endl;
+	for(unsigned int i=0;i<sizeof(teller_counts)/sizeof(teller_counts[0]);i++)
+	{
+		double rate = run< mutex_queue<customer> >(teller_counts[i], total, &max_depth, &contended);
+		std::cout << teller_counts[i] << ",mutex," << rate << "," << max_depth << "," << contended << std::endl;
+
+		rate = run< mpmc_queue<customer, CUSTOMER_QUEUE_CAPACITY> >(teller_counts[i], total, &max_depth, &contended);
+		std::cout << teller_counts[i] << ",lockfree," << rate << "," << max_depth << "," << contended << std::endl;
+
+		rate = run_lines(teller_counts[i], false, total, &max_depth, &contended);
+		std::cout << teller_counts[i] << ",lines_jsq," << rate << "," << max_depth << "," << contended << std::endl;
+
+		rate = run_lines(teller_counts[i], true, total, &max_depth, &contended);
+		std::cout << teller_counts[i] << ",lines_p2c," << rate << "," << max_depth << "," << contended << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "des.h"
+#include "mpmc_queue.h"
+#include "region.h"
+
+// what one worker simulates and measures, on its own cache lines
+typedef struct
+{
+	alignas(CACHE_LINE_SIZE) const region_params *params;
+	unsigned int first_branch;
+	unsigned int last_branch;	// one past the last
+	unsigned long total_customers;
+	teller_stats all_tellers;
+	stats_accumulator metrics[REPORTED_METRICS];
+} region_shard;
+
+// worker thread, simulates its block of branches one after the other
+static void *region_worker(void *argument)
+{
+	region_shard *shard = (region_shard *)argument;
+
+	for(unsigned int i=shard->first_branch;i<shard->last_branch;i++)
+	{
+		des_bank *bank = new des_bank;
+		des_init(bank, &shard->params->model, replication_seed(shard->params->seed, i));
+		des_run(bank);
+		bank_report report = des_report(bank);
+		delete bank;
+
+		double metrics[REPORTED_METRICS];
+		report_to_metrics(report, metrics);
+		for(int j=0;j<REPORTED_METRICS;j++)
+		{
+			stats_add(&shard->metrics[j], metrics[j]);
+		}
+		teller_stats_merge(&shard->all_tellers, &report.all_tellers);
+		shard->total_customers += report.total_customers;
+	}
+	return NULL;
+}
+
+// The answer only depends on the seed and the number of threads, the
+// shards are merged in branch order whichever worker finished first.
+region_report run_region(const region_params &params)
+{
+	region_report report;
+	struct timespec start, end;
+
+	unsigned int threads = params.threads;
+	if(0 == threads)
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cores > 0 ? cores : 1;
+	}
+	if(threads > params.branches)
+	{
+		threads = params.branches > 0 ? params.branches : 1;
+	}
+
+	region_shard *shards = new region_shard[threads];
+	pthread_t *workers = new pthread_t[threads];
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(unsigned int i=0;i<threads;i++)
+	{
+		shards[i].params = &params;
+		shards[i].first_branch = (unsigned long)params.branches * i / threads;
+		shards[i].last_branch = (unsigned long)params.branches * (i + 1) / threads;
+		shards[i].total_customers = 0;
+		teller_stats_init(&shards[i].all_tellers);
+		for(int j=0;j<REPORTED_METRICS;j++)
+		{
+			stats_init(&shards[i].metrics[j]);
+		}
+		pthread_create(&workers[i], NULL, &region_worker, &shards[i]);
+	}
+
+	report.branches = params.branches;
+	report.threads = threads;
+	report.total_customers = 0;
+	teller_stats_init(&report.all_tellers);
+	for(int j=0;j<REPORTED_METRICS;j++)
+	{
+		stats_init(&report.metrics[j]);
+	}
+
+	for(unsigned int i=0;i<threads;i++)
+	{
+		pthread_join(workers[i], NULL);
+		report.total_customers += shards[i].total_customers;
+		teller_stats_merge(&report.all_tellers, &shards[i].all_tellers);
+		for(int j=0;j<REPORTED_METRICS;j++)
+		{
+			stats_merge(&report.metrics[j], &shards[i].metrics[j]);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	report.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	delete[] shards;
+	delete[] workers;
+	return report;
+}
+
+void print_region_report(const region_report &report)
+{
+	std::cout << "Branches: " << report.branches << " on " << report.threads << " threads in "
+			<< report.seconds << " s (" << report.branches / report.seconds << " branch days per second)" << std::endl;
+	std::cout << "The total number of customers serviced in the region is " << report.total_customers << std::endl;
+	std::cout << "The average customer wait in the region is " << report.all_tellers.wait_queue.mean << " Seconds" << std::endl;
+	std::cout << "The region customer wait percentiles p50/p90/p99/p99.9 are "
+			<< percentile_seconds(&report.all_tellers.wait_queue_histogram, &report.all_tellers.wait_queue, 50) << " / "
+			<< percentile_seconds(&report.all_tellers.wait_queue_histogram, &report.all_tellers.wait_queue, 90) << " / "
+			<< percentile_seconds(&report.all_tellers.wait_queue_histogram, &report.all_tellers.wait_queue, 99) << " / "
+			<< percentile_seconds(&report.all_tellers.wait_queue_histogram, &report.all_tellers.wait_queue, 99.9) << " Seconds" << std::endl;
+	for(int i=0;i<REPORTED_METRICS;i++)
+	{
+		std::cout << metric_name(i) << " per branch: " << report.metrics[i].mean
+				<< " (" << report.metrics[i].min << " to " << report.metrics[i].max << ")" << std::endl;
+	}
+}
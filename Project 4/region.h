@@ -0,0 +1,42 @@
+#ifndef _region_
+#define _region_
+
+#include "bank.h"
+#include "replication.h"
+#include "stats.h"
+
+// Many branches of one region simulated in virtual time on the same day.
+//
+// Every branch is its own des_bank with its own seed. The branches are cut
+// into one contiguous block per worker thread before any thread starts, and
+// a worker only writes into its own shard, so the workers share nothing
+// while running: no lock, no shared counter and no cache line written by
+// two threads. The shards are merged in order once every worker is done.
+
+typedef struct
+{
+	unsigned int branches;
+	unsigned int threads;		// 0 uses every online core
+	unsigned int seed;			// branch i uses replication_seed(seed, i)
+	bank_params model;			// the same for every branch
+} region_params;
+
+typedef struct
+{
+	unsigned int branches;
+	unsigned int threads;
+	unsigned long total_customers;
+
+	// every customer and teller of every branch pooled together
+	teller_stats all_tellers;
+
+	// the spread of each branch's end of day metrics over the branches
+	stats_accumulator metrics[REPORTED_METRICS];
+
+	double seconds;				// real time the simulation took
+} region_report;
+
+region_report run_region(const region_params &params);
+void print_region_report(const region_report &report);
+
+#endif
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "des.h"
+#include "replication.h"
+
+static const char *metric_names[REPORTED_METRICS] =
+{
+	"customers serviced",
+	"average customer wait (s)",
+	"average time with teller (s)",
+	"average teller wait (s)",
+	"maximum customer wait (s)",
+	"maximum teller wait (s)",
+	"maximum transaction time (s)",
+	"maximum queue depth"
+};
+
+// two sided 95% student t values for 1 to 30 degrees of freedom
+static const double t_table[30] =
+{
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+// finished reports waiting for their turn to be folded, per thread
+#define REORDER_SLOTS_PER_THREAD 2
+
+// Shared between the workers and the thread folding in their results.
+// Replication i is kept in slot i % window until it is folded, a worker
+// only starts a replication once its slot is free, so memory depends on
+// the number of threads and not on max_replications.
+typedef struct
+{
+	replication_params params;
+	bank_report *reports;
+	bool *finished;
+	unsigned int window;
+	unsigned int next_replication;	// next one a worker should pick up
+	unsigned int folded;			// replications folded into the summary
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t replication_done;
+	pthread_cond_t slot_free;
+} replication_runner;
+
+// spreads the seeds so neighbouring replications get unrelated streams
+unsigned int replication_seed(unsigned int seed, unsigned int replication)
+{
+	unsigned long long z = seed + (unsigned long long)(replication + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return (unsigned int)(z ^ (z >> 31));
+}
+
+// the eight reported metrics in the order of metric_names
+void report_to_metrics(const bank_report &report, double *metrics)
+{
+	metrics[0] = report.total_customers;
+	metrics[1] = report.average_wait_queue;
+	metrics[2] = report.average_transaction_time;
+	metrics[3] = report.teller_average_time_waiting;
+	metrics[4] = report.max_wait_queue;
+	metrics[5] = report.teller_maximum_time_waiting;
+	metrics[6] = report.max_transaction_time;
+	metrics[7] = report.max_queue_size;
+}
+
+const char *metric_name(int metric)
+{
+	return metric_names[metric];
+}
+
+// half width of the 95% confidence interval of the mean
+double confidence_half_width(const stats_accumulator *stats)
+{
+	if(stats->count < 2)
+	{
+		return 0;
+	}
+
+	unsigned long degrees = stats->count - 1;
+	double t = 1.960;
+	if(degrees <= 30)
+	{
+		t = t_table[degrees - 1];
+	}
+	else
+	{
+		// Cornish-Fisher expansion around the normal value
+		t = 1.960 + (1.960 * 1.960 * 1.960 + 1.960) / (4 * degrees);
+	}
+	return t * sqrt(stats_variance(stats) / stats->count);
+}
+
+static bool precise_enough(const replication_summary &summary, double target_relative_width)
+{
+	if(target_relative_width <= 0 || summary.replications < MIN_REPLICATIONS)
+	{
+		return false;
+	}
+	for(int i=0;i<REPORTED_METRICS;i++)
+	{
+		double mean = fabs(summary.metrics[i].mean);
+		if(confidence_half_width(&summary.metrics[i]) > target_relative_width * mean)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// worker thread, simulates replications until there are none left
+static void *replication_worker(void *argument)
+{
+	replication_runner *runner = (replication_runner *)argument;
+
+	while(1)
+	{
+		pthread_mutex_lock(&runner->lock);
+		while(!runner->stop && runner->next_replication < runner->params.max_replications
+				&& runner->next_replication >= runner->folded + runner->window)
+		{
+			pthread_cond_wait(&runner->slot_free, &runner->lock);
+		}
+		if(runner->stop || runner->next_replication >= runner->params.max_replications)
+		{
+			pthread_mutex_unlock(&runner->lock);
+			return NULL;
+		}
+		unsigned int replication = runner->next_replication++;
+		pthread_mutex_unlock(&runner->lock);
+
+		des_bank *bank = new des_bank;
+		des_init(bank, &runner->params.model, replication_seed(runner->params.seed, replication));
+		des_run(bank);
+		bank_report report = des_report(bank);
+		delete bank;
+
+		pthread_mutex_lock(&runner->lock);
+		runner->reports[replication % runner->window] = report;
+		runner->finished[replication % runner->window] = true;
+		pthread_cond_signal(&runner->replication_done);
+		pthread_mutex_unlock(&runner->lock);
+	}
+}
+
+// Results are folded in replication order, so the answer only depends on
+// the seed and not on which worker finished first.
+replication_summary run_replications(const replication_params &params)
+{
+	replication_runner runner;
+	replication_summary summary;
+
+	unsigned int threads = params.threads;
+	if(0 == threads)
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cores > 0 ? cores : 1;
+	}
+
+	runner.params = params;
+	runner.window = REORDER_SLOTS_PER_THREAD * threads;
+	runner.reports = new bank_report[runner.window];
+	runner.finished = new bool[runner.window]();
+	runner.next_replication = 0;
+	runner.folded = 0;
+	runner.stop = false;
+	pthread_mutex_init(&runner.lock, NULL);
+	pthread_cond_init(&runner.replication_done, NULL);
+	pthread_cond_init(&runner.slot_free, NULL);
+
+	summary.replications = 0;
+	for(int i=0;i<REPORTED_METRICS;i++)
+	{
+		stats_init(&summary.metrics[i]);
+	}
+	stats_init(&summary.wait_queue);
+	histogram_init(&summary.wait_queue_histogram);
+
+	pthread_t *workers = new pthread_t[threads];
+	for(unsigned int i=0;i<threads;i++)
+	{
+		pthread_create(&workers[i], NULL, &replication_worker, &runner);
+	}
+
+	pthread_mutex_lock(&runner.lock);
+	while(summary.replications < params.max_replications)
+	{
+		unsigned int slot = summary.replications % runner.window;
+		while(!runner.finished[slot])
+		{
+			pthread_cond_wait(&runner.replication_done, &runner.lock);
+		}
+
+		double metrics[REPORTED_METRICS];
+		report_to_metrics(runner.reports[slot], metrics);
+		for(int i=0;i<REPORTED_METRICS;i++)
+		{
+			stats_add(&summary.metrics[i], metrics[i]);
+		}
+		stats_merge(&summary.wait_queue, &runner.reports[slot].all_tellers.wait_queue);
+		histogram_merge(&summary.wait_queue_histogram, &runner.reports[slot].all_tellers.wait_queue_histogram);
+		summary.replications++;
+
+		// the slot can take the replication window places further on
+		runner.finished[slot] = false;
+		runner.folded = summary.replications;
+		pthread_cond_broadcast(&runner.slot_free);
+
+		if(precise_enough(summary, params.target_relative_width))
+		{
+			runner.stop = true;
+			pthread_cond_broadcast(&runner.slot_free);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&runner.lock);
+
+	for(unsigned int i=0;i<threads;i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	delete[] workers;
+	delete[] runner.reports;
+	delete[] runner.finished;
+	pthread_mutex_destroy(&runner.lock);
+	pthread_cond_destroy(&runner.replication_done);
+	pthread_cond_destroy(&runner.slot_free);
+	return summary;
+}
+
+void print_replication_summary(const replication_summary &summary)
+{
+	std::cout << "Replications: " << summary.replications << std::endl;
+	for(int i=0;i<REPORTED_METRICS;i++)
+	{
+		double half_width = confidence_half_width(&summary.metrics[i]);
+		std::cout << metric_names[i] << ": " << summary.metrics[i].mean
+				<< " +/- " << half_width << " (95% CI "
+				<< summary.metrics[i].mean - half_width << " to "
+				<< summary.metrics[i].mean + half_width << ")" << std::endl;
+	}
+}
+
+// simulates the days of params and prints one CSV row of customer wait
+static void print_comparison_row(const char *name, replication_params params)
+{
+	static const double percentiles[] = {50, 90, 99, 99.9};
+
+	if(0 == params.max_replications)
+	{
+		params.max_replications = DEFAULT_COMPARISON_REPLICATIONS;
+	}
+
+	replication_summary summary = run_replications(params);
+	std::cout << name << "," << summary.replications
+			<< "," << summary.metrics[1].mean << "," << confidence_half_width(&summary.metrics[1]);
+	for(unsigned int i=0;i<sizeof(percentiles)/sizeof(percentiles[0]);i++)
+	{
+		std::cout << "," << percentile_seconds(&summary.wait_queue_histogram, &summary.wait_queue, percentiles[i]);
+	}
+	std::cout << "," << summary.wait_queue.max << std::endl;
+}
+
+// Runs the same days (same seeds, so the same customers) under every
+// queueing discipline and prints the customer wait of each side by side.
+void compare_disciplines(const replication_params &params)
+{
+	std::cout << "discipline,replications,average_wait,average_wait_ci,p50,p90,p99,p99.9,max_wait" << std::endl;
+	for(int i=0;i<NUMBER_OF_DISCIPLINES;i++)
+	{
+		replication_params current = params;
+		current.model.discipline = (queue_discipline)i;
+		print_comparison_row(discipline_name(current.model.discipline), current);
+	}
+}
+
+// the same for one line against a line per teller
+void compare_routings(const replication_params &params)
+{
+	std::cout << "routing,replications,average_wait,average_wait_ci,p50,p90,p99,p99.9,max_wait" << std::endl;
+	for(int i=0;i<NUMBER_OF_ROUTINGS;i++)
+	{
+		replication_params current = params;
+		current.model.routing = (queue_routing)i;
+		print_comparison_row(routing_name(current.model.routing), current);
+	}
+}
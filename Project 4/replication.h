@@ -0,0 +1,49 @@
+#ifndef _replication_
+#define _replication_
+
+#include "bank.h"
+#include "stats.h"
+
+// Monte Carlo runner: simulates many independent days in virtual time, each
+// with its own seed, spread over all cores, and reports every metric as a
+// mean with a 95% confidence interval.
+
+#define REPORTED_METRICS 8
+
+// fewest replications before the confidence interval is trusted
+#define MIN_REPLICATIONS 10
+
+// days simulated for each discipline or routing when comparing them
+// without -r
+#define DEFAULT_COMPARISON_REPLICATIONS 1000
+
+typedef struct
+{
+	unsigned int max_replications;
+	unsigned int threads;			// 0 uses every online core
+	unsigned int seed;				// replication i uses a seed derived from this
+	bank_params model;
+	double target_relative_width;	// stop once every interval half width is
+									// within this fraction of its mean, 0 never stops early
+} replication_params;
+
+typedef struct
+{
+	unsigned int replications;		// how many were used
+	stats_accumulator metrics[REPORTED_METRICS];
+
+	// every customer's wait over all the days, for the tails
+	stats_accumulator wait_queue;
+	histogram wait_queue_histogram;
+} replication_summary;
+
+unsigned int replication_seed(unsigned int seed, unsigned int replication);
+void report_to_metrics(const bank_report &report, double *metrics);
+const char *metric_name(int metric);
+double confidence_half_width(const stats_accumulator *stats);
+replication_summary run_replications(const replication_params &params);
+void print_replication_summary(const replication_summary &summary);
+void compare_disciplines(const replication_params &params);
+void compare_routings(const replication_params &params);
+
+#endif
@@ -0,0 +1,189 @@
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "rng.h"
+
+#define TWO_PI 6.283185307179586
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+// used to expand a seed into generator state
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// top 52 bits as a double in [0, 1), done through the exponent bits so the
+// SIMD path does not need a 64 bit integer to double conversion
+static inline double to_uniform(uint64_t x)
+{
+	uint64_t bits = (x >> 12) | 0x3FF0000000000000ULL;
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value - 1.0;
+}
+
+void rng_seed(rng_state *rng, uint64_t seed)
+{
+	for(int i=0;i<4;i++)
+	{
+		rng->s[i] = splitmix64(&seed);
+	}
+}
+
+uint64_t rng_next(rng_state *rng)
+{
+	uint64_t *s = rng->s;
+	uint64_t result = rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+// uniform random integer in [low, high]
+long rng_between(rng_state *rng, long low, long high)
+{
+	uint64_t range = (uint64_t)(high - low) + 1;
+	return low + (long)(((rng_next(rng) >> 32) * range) >> 32);
+}
+
+double rng_uniform(rng_state *rng)
+{
+	return to_uniform(rng_next(rng));
+}
+
+double rng_exponential(rng_state *rng, double mean)
+{
+	return -mean * log1p(-rng_uniform(rng));
+}
+
+double rng_lognormal(rng_state *rng, double mu, double sigma)
+{
+	// Box-Muller, 1 - u keeps the logarithm away from 0
+	double u1 = 1.0 - rng_uniform(rng);
+	double u2 = rng_uniform(rng);
+	double z = sqrt(-2.0 * log(u1)) * cos(TWO_PI * u2);
+	return exp(mu + sigma * z);
+}
+
+// lane i starts from the seed stepped i times, so lanes are unrelated
+void rng_batch_seed(rng_batch *rng, uint64_t seed)
+{
+	for(int lane=0;lane<RNG_LANES;lane++)
+	{
+		for(int i=0;i<4;i++)
+		{
+			rng->s[i][lane] = splitmix64(&seed);
+		}
+	}
+}
+
+// next RNG_LANES raw values, one per lane
+static inline void batch_next(rng_batch *rng, uint64_t *result)
+{
+#if defined(__AVX2__) && RNG_LANES == 4
+	__m256i s0 = _mm256_loadu_si256((const __m256i *)rng->s[0]);
+	__m256i s1 = _mm256_loadu_si256((const __m256i *)rng->s[1]);
+	__m256i s2 = _mm256_loadu_si256((const __m256i *)rng->s[2]);
+	__m256i s3 = _mm256_loadu_si256((const __m256i *)rng->s[3]);
+
+	// rotl(s1 * 5, 7) * 9 with shifts, AVX2 has no 64 bit multiply
+	__m256i x = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+	x = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+	x = _mm256_add_epi64(_mm256_slli_epi64(x, 3), x);
+	_mm256_storeu_si256((__m256i *)result, x);
+
+	__m256i t = _mm256_slli_epi64(s1, 17);
+	s2 = _mm256_xor_si256(s2, s0);
+	s3 = _mm256_xor_si256(s3, s1);
+	s1 = _mm256_xor_si256(s1, s2);
+	s0 = _mm256_xor_si256(s0, s3);
+	s2 = _mm256_xor_si256(s2, t);
+	s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+
+	_mm256_storeu_si256((__m256i *)rng->s[0], s0);
+	_mm256_storeu_si256((__m256i *)rng->s[1], s1);
+	_mm256_storeu_si256((__m256i *)rng->s[2], s2);
+	_mm256_storeu_si256((__m256i *)rng->s[3], s3);
+#else
+	uint64_t *s0 = rng->s[0];
+	uint64_t *s1 = rng->s[1];
+	uint64_t *s2 = rng->s[2];
+	uint64_t *s3 = rng->s[3];
+
+	for(int lane=0;lane<RNG_LANES;lane++)
+	{
+		result[lane] = rotl(s1[lane] * 5, 7) * 9;
+		uint64_t t = s1[lane] << 17;
+		s2[lane] ^= s0[lane];
+		s3[lane] ^= s1[lane];
+		s1[lane] ^= s2[lane];
+		s0[lane] ^= s3[lane];
+		s2[lane] ^= t;
+		s3[lane] = rotl(s3[lane], 45);
+	}
+#endif
+}
+
+void rng_fill_uniform(rng_batch *rng, double *samples, size_t count)
+{
+	uint64_t raw[RNG_LANES];
+	size_t i = 0;
+
+	while(i < count)
+	{
+		batch_next(rng, raw);
+		for(int lane=0;lane<RNG_LANES && i<count;lane++, i++)
+		{
+			samples[i] = to_uniform(raw[lane]);
+		}
+	}
+}
+
+void rng_fill_exponential(rng_batch *rng, double *samples, size_t count, double mean)
+{
+	rng_fill_uniform(rng, samples, count);
+	for(size_t i=0;i<count;i++)
+	{
+		samples[i] = -mean * log1p(-samples[i]);
+	}
+}
+
+void rng_fill_lognormal(rng_batch *rng, double *samples, size_t count, double mu, double sigma)
+{
+	rng_fill_uniform(rng, samples, count);
+
+	// Box-Muller turns every pair of uniforms into a pair of normals
+	size_t pairs = count / 2;
+	for(size_t i=0;i<pairs;i++)
+	{
+		double radius = sqrt(-2.0 * log(1.0 - samples[2 * i]));
+		double angle = TWO_PI * samples[2 * i + 1];
+		samples[2 * i] = exp(mu + sigma * radius * cos(angle));
+		samples[2 * i + 1] = exp(mu + sigma * radius * sin(angle));
+	}
+	if(count % 2)
+	{
+		double u2;
+		rng_fill_uniform(rng, &u2, 1);
+		double radius = sqrt(-2.0 * log(1.0 - samples[count - 1]));
+		samples[count - 1] = exp(mu + sigma * radius * cos(TWO_PI * u2));
+	}
+}
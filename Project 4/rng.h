@@ -0,0 +1,39 @@
+#ifndef _rng_
+#define _rng_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Random numbers for the simulation. Every thread owns its generator
+// (xoshiro256**), so there is no hidden shared state like with rand().
+//
+// rng_batch runs RNG_LANES independent generators side by side so blocks of
+// samples can be produced with SIMD instructions (AVX2 when the compiler
+// targets it, otherwise plain loops over the lanes the compiler can
+// vectorise), then turned into uniform, exponential or lognormal samples.
+
+#define RNG_LANES 4
+
+typedef struct
+{
+	uint64_t s[4];
+} rng_state;
+
+typedef struct
+{
+	uint64_t s[4][RNG_LANES];	// word, then lane
+} rng_batch;
+
+void rng_seed(rng_state *rng, uint64_t seed);
+uint64_t rng_next(rng_state *rng);
+long rng_between(rng_state *rng, long low, long high);
+double rng_uniform(rng_state *rng);
+double rng_exponential(rng_state *rng, double mean);
+double rng_lognormal(rng_state *rng, double mu, double sigma);
+
+void rng_batch_seed(rng_batch *rng, uint64_t seed);
+void rng_fill_uniform(rng_batch *rng, double *samples, size_t count);
+void rng_fill_exponential(rng_batch *rng, double *samples, size_t count, double mean);
+void rng_fill_lognormal(rng_batch *rng, double *samples, size_t count, double mu, double sigma);
+
+#endif
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "series.h"
+
+static const char *column_names[SERIES_COLUMNS] = {"queue_depth", "busy_tellers", "tellers_on_break"};
+
+void series_init(time_series *series, sim_ticks interval)
+{
+	series->interval = interval;
+	for(int i=0;i<SERIES_COLUMNS;i++)
+	{
+		series->columns[i].clear();
+	}
+}
+
+void series_add(time_series *series, uint32_t queue_depth, uint32_t busy_tellers, uint32_t tellers_on_break)
+{
+	series->columns[SERIES_QUEUE_DEPTH].push_back(queue_depth);
+	series->columns[SERIES_BUSY_TELLERS].push_back(busy_tellers);
+	series->columns[SERIES_TELLERS_ON_BREAK].push_back(tellers_on_break);
+}
+
+// writes the header and the columns, returns false if the file could not
+// be written
+bool series_write(const time_series *series, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if(NULL == file)
+	{
+		return false;
+	}
+
+	series_header header;
+	memcpy(header.magic, SERIES_MAGIC, sizeof(header.magic));
+	header.version = SERIES_VERSION;
+	header.columns = SERIES_COLUMNS;
+	header.interval = series->interval;
+	header.ticks_per_second = TICKS_PER_SECOND;
+	header.samples = series->columns[0].size();
+
+	bool written = 1 == fwrite(&header, sizeof(header), 1, file);
+	for(int i=0;i<SERIES_COLUMNS && written;i++)
+	{
+		written = header.samples == fwrite(series->columns[i].data(), sizeof(uint32_t), header.samples, file);
+	}
+	return 0 == fclose(file) && written;
+}
+
+const char *series_column_name(int column)
+{
+	return column_names[column];
+}
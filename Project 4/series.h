@@ -0,0 +1,52 @@
+#ifndef _series_
+#define _series_
+
+#include <vector>
+#include <stdint.h>
+
+#include "sim_time.h"
+
+// Queue depth, busy tellers and tellers on break sampled every simulated
+// minute, to see when during the day the queue builds up.
+//
+// The file is columnar: a series_header, then every column as one array
+// of uint32_t with header.samples entries, in the order of the
+// series_column enum. Sample i was taken at i * header.interval ticks.
+// series_csv.cc exports a file as CSV.
+
+#define SERIES_MAGIC "BANKSERS"
+#define SERIES_VERSION 1
+
+#define SERIES_INTERVAL TICKS_PER_MINUTE
+
+typedef enum
+{
+	SERIES_QUEUE_DEPTH = 0,
+	SERIES_BUSY_TELLERS,
+	SERIES_TELLERS_ON_BREAK
+} series_column;
+
+#define SERIES_COLUMNS 3
+
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t columns;
+	int64_t interval;		// ticks between samples
+	int64_t ticks_per_second;
+	uint64_t samples;
+} series_header;
+
+typedef struct
+{
+	sim_ticks interval;
+	std::vector<uint32_t> columns[SERIES_COLUMNS];
+} time_series;
+
+void series_init(time_series *series, sim_ticks interval);
+void series_add(time_series *series, uint32_t queue_depth, uint32_t busy_tellers, uint32_t tellers_on_break);
+bool series_write(const time_series *series, const char *path);
+const char *series_column_name(int column);
+
+#endif
@@ -0,0 +1,62 @@
+// Exports a time series file written with -m as CSV: the simulated minute
+// of each sample followed by every column.
+//
+// usage: series_csv file
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "series.h"
+
+int main(int argc, char *argv[])
+{
+	if(argc != 2)
+	{
+		std::cerr << "usage: " << argv[0] << " file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	series_header header;
+	if(NULL == file || 1 != fread(&header, sizeof(header), 1, file)
+		|| 0 != memcmp(header.magic, SERIES_MAGIC, sizeof(header.magic)) || SERIES_VERSION != header.version
+		|| SERIES_COLUMNS != header.columns)
+	{
+		std::cerr << argv[1] << " is not a time series file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint32_t> columns[SERIES_COLUMNS];
+	for(int i=0;i<SERIES_COLUMNS;i++)
+	{
+		columns[i].resize(header.samples);
+		if(header.samples != fread(columns[i].data(), sizeof(uint32_t), header.samples, file))
+		{
+			std::cerr << argv[1] << " is cut short" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	fclose(file);
+
+	std::cout << "minute";
+	for(int i=0;i<SERIES_COLUMNS;i++)
+	{
+		std::cout << "," << series_column_name(i);
+	}
+	std::cout << std::endl;
+
+	for(uint64_t i=0;i<header.samples;i++)
+	{
+		std::cout << (double)(i * header.interval) / (60 * header.ticks_per_second);
+		for(int j=0;j<SERIES_COLUMNS;j++)
+		{
+			std::cout << "," << columns[j][i];
+		}
+		std::cout << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
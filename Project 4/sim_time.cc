@@ -0,0 +1,62 @@
+#include <math.h>
+
+#include "sim_time.h"
+
+// real = simulated * real_part / simulated_part, fraction in lowest terms
+static int64_t real_part = 1;
+static int64_t simulated_part = TICKS_PER_MINUTE / REAL_NS_PER_SIMULATED_MINUTE;
+
+static int64_t gcd(int64_t a, int64_t b)
+{
+	while(b != 0)
+	{
+		int64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// a * numerator / denominator without overflowing the intermediate product
+static int64_t scale(int64_t a, int64_t numerator, int64_t denominator)
+{
+	return (a / denominator) * numerator + (a % denominator) * numerator / denominator;
+}
+
+sim_ticks seconds_to_ticks(double seconds)
+{
+	return (sim_ticks)llround(seconds * TICKS_PER_SECOND);
+}
+
+void set_time_scale(int64_t real_ns_per_simulated_minute)
+{
+	int64_t divisor = gcd(real_ns_per_simulated_minute, TICKS_PER_MINUTE);
+	real_part = real_ns_per_simulated_minute / divisor;
+	simulated_part = TICKS_PER_MINUTE / divisor;
+}
+
+int64_t simulated_to_real_ns(sim_ticks ticks)
+{
+	return scale(ticks, real_part, simulated_part);
+}
+
+sim_ticks real_ns_to_simulated(int64_t real_ns)
+{
+	return scale(real_ns, simulated_part, real_part);
+}
+
+// CLOCK_REALTIME as one number, it is what sem_timedwait compares against
+int64_t real_clock_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (int64_t)now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+struct timespec ns_to_timespec(int64_t ns)
+{
+	struct timespec time;
+	time.tv_sec = ns / NANOSECONDS_PER_SECOND;
+	time.tv_nsec = ns % NANOSECONDS_PER_SECOND;
+	return time;
+}
@@ -0,0 +1,45 @@
+#ifndef _sim_time_
+#define _sim_time_
+
+#include <stdint.h>
+#include <time.h>
+
+// Simulated time is a single 64 bit count of simulated nanoseconds since
+// the bank opened, so seconds and minutes convert exactly and comparing
+// two times is one integer compare. A signed 64 bit count covers about
+// 292 simulated years.
+//
+// The wall clock simulation maps simulated time to real time with a scale
+// (by default 100 ms of real time per simulated minute). The scale is kept
+// as a reduced fraction so converting never overflows or loses more than
+// the last real nanosecond.
+
+typedef int64_t sim_ticks;
+
+#define TICKS_PER_SECOND ((sim_ticks)1000000000)
+#define TICKS_PER_MINUTE (60 * TICKS_PER_SECOND)
+#define TICKS_PER_HOUR (60 * TICKS_PER_MINUTE)
+
+#define SECONDS_TO_TICKS(seconds) ((sim_ticks)(seconds) * TICKS_PER_SECOND)
+#define MINUTES_TO_TICKS(minutes) ((sim_ticks)(minutes) * TICKS_PER_MINUTE)
+
+// default scale, real nanoseconds that pass per simulated minute
+#define REAL_NS_PER_SIMULATED_MINUTE 100000000
+
+#define NANOSECONDS_PER_SECOND 1000000000LL
+
+static inline double ticks_to_seconds(sim_ticks ticks)
+{
+	return (double)ticks / TICKS_PER_SECOND;
+}
+
+sim_ticks seconds_to_ticks(double seconds);
+
+void set_time_scale(int64_t real_ns_per_simulated_minute);
+int64_t simulated_to_real_ns(sim_ticks ticks);
+sim_ticks real_ns_to_simulated(int64_t real_ns);
+
+int64_t real_clock_ns(void);
+struct timespec ns_to_timespec(int64_t ns);
+
+#endif
@@ -0,0 +1,382 @@
+// Staffing sweep: finds, for every combination of arrival gap range and
+// transaction time range, the fewest tellers that keep the 95th
+// percentile customer wait under a target.
+//
+// Every cell (load, teller count) is simulated with the replication
+// runner, which spreads the cell's days over the worker threads. Cells
+// whose answer already follows from other cells are not simulated:
+//   - more tellers never make the wait longer, so within one load the
+//     smallest teller count is found by bisection over the teller grid
+//   - a heavier load (shorter gaps and longer transactions) never needs
+//     fewer tellers than a lighter one, and a lighter load never needs
+//     more than a heavier one, so solved loads bound the search of the
+//     others. Loads are solved lightest first.
+//
+// usage: staffing [-n tellers] [-g gaps] [-e times] [-p seconds] [-r replications] [-j threads] [-s seed] [-a dist] [-t dist]
+//   -n  teller counts to try, a range 1:10 (default) or a list 2,3,5
+//   -g  arrival gap ranges in minutes, e.g. 1-4,1-3,1-2 (default 1-4)
+//   -e  transaction time ranges in seconds, e.g. 30-360,60-300
+//       (default 30-360)
+//   -p  target 95th percentile customer wait in seconds, 60 by default
+//   -r  days simulated per cell, 200 by default
+//   -j  worker threads, defaults to every core
+//   -s, -a, -t  seed and distributions as for the bank simulation
+//
+// Prints every cell as CSV (pruned cells without a wait), then the
+// minimum staffing of each load.
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bank.h"
+#include "replication.h"
+
+#define DEFAULT_TARGET_P95_SECONDS 60
+#define DEFAULT_CELL_REPLICATIONS 200
+
+typedef struct
+{
+	long low;
+	long high;
+} range;
+
+typedef enum
+{
+	UNKNOWN = 0,
+	MEETS,			// simulated, p95 within target
+	MISSES,			// simulated, p95 above target
+	PRUNED_MEETS,	// follows from other cells
+	PRUNED_MISSES
+} cell_status;
+
+typedef struct
+{
+	cell_status status;
+	double p95_wait;
+	double average_wait;
+} cell;
+
+// one arrival gap range and transaction time range
+typedef struct
+{
+	range gap;
+	range service;
+	int minimum;		// index into the teller grid, grid size if none is enough
+	bool solved;
+	std::vector<cell> cells;
+} load;
+
+// "a-b" or "a"
+static bool parse_range(const char *text, range *result)
+{
+	char *end;
+	result->low = strtol(text, &end, 10);
+	result->high = result->low;
+	if('-' == *end)
+	{
+		result->high = strtol(end + 1, &end, 10);
+	}
+	return '\0' == *end && result->low > 0 && result->high >= result->low;
+}
+
+// comma separated ranges
+static bool parse_ranges(const char *text, std::vector<range> *result)
+{
+	char buffer[256];
+	strncpy(buffer, text, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	result->clear();
+	for(char *item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ","))
+	{
+		range current;
+		if(!parse_range(item, &current))
+		{
+			return false;
+		}
+		result->push_back(current);
+	}
+	return !result->empty();
+}
+
+// "a:b" or a comma separated list, sorted and without duplicates
+static bool parse_tellers(const char *text, std::vector<int> *result)
+{
+	result->clear();
+	const char *colon = strchr(text, ':');
+	if(colon != NULL)
+	{
+		int first = atoi(text);
+		int last = atoi(colon + 1);
+		for(int i=first;i<=last;i++)
+		{
+			result->push_back(i);
+		}
+	}
+	else
+	{
+		std::vector<range> counts;
+		if(!parse_ranges(text, &counts))
+		{
+			return false;
+		}
+		for(unsigned int i=0;i<counts.size();i++)
+		{
+			for(long j=counts[i].low;j<=counts[i].high;j++)
+			{
+				result->push_back(j);
+			}
+		}
+	}
+
+	std::sort(result->begin(), result->end());
+	result->erase(std::unique(result->begin(), result->end()), result->end());
+	return !result->empty() && result->front() > 0;
+}
+
+// true if load1 brings at least as much work as load2
+static bool at_least_as_heavy(const load &load1, const load &load2)
+{
+	return load1.gap.low <= load2.gap.low && load1.gap.high <= load2.gap.high
+		&& load1.service.low >= load2.service.low && load1.service.high >= load2.service.high;
+}
+
+// average number of busy tellers the load needs, to solve the lightest first
+static double intensity(const load &current)
+{
+	return (current.service.low + current.service.high) / 2.0 / (30.0 * (current.gap.low + current.gap.high));
+}
+
+static bool lighter(const load *load1, const load *load2)
+{
+	return intensity(*load1) < intensity(*load2);
+}
+
+static void simulate(load *current, int tellers, cell *result, const replication_params &base, double target)
+{
+	replication_params params = base;
+	params.model.tellers = tellers;
+	params.model.min_arrival_minutes = current->gap.low;
+	params.model.max_arrival_minutes = current->gap.high;
+	params.model.min_service_seconds = current->service.low;
+	params.model.max_service_seconds = current->service.high;
+
+	replication_summary summary = run_replications(params);
+	result->p95_wait = percentile_seconds(&summary.wait_queue_histogram, &summary.wait_queue, 95);
+	result->average_wait = summary.metrics[1].mean;
+	result->status = result->p95_wait <= target ? MEETS : MISSES;
+}
+
+// smallest teller count meeting the target, using what the loads solved
+// so far say about this one
+static void solve(load *current, std::vector<load> &loads, const std::vector<int> &tellers, const replication_params &base, double target)
+{
+	int grid = tellers.size();
+	int low = 0;		// every count below low misses
+	int high = grid;	// count high meets (grid: nothing known to meet)
+
+	for(unsigned int i=0;i<loads.size();i++)
+	{
+		if(!loads[i].solved || &loads[i] == current)
+		{
+			continue;
+		}
+		if(at_least_as_heavy(*current, loads[i]))
+		{
+			low = std::max(low, loads[i].minimum);
+		}
+		if(at_least_as_heavy(loads[i], *current))
+		{
+			high = std::min(high, loads[i].minimum);
+		}
+	}
+	low = std::min(low, high);
+
+	// bisect for the first count that meets the target in [low, high)
+	while(low < high)
+	{
+		int middle = low + (high - low) / 2;
+		simulate(current, tellers[middle], &current->cells[middle], base, target);
+		if(MEETS == current->cells[middle].status)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+
+	current->minimum = high;
+	current->solved = true;
+	for(int i=0;i<grid;i++)
+	{
+		if(UNKNOWN == current->cells[i].status)
+		{
+			current->cells[i].status = i < high ? PRUNED_MISSES : PRUNED_MEETS;
+		}
+	}
+}
+
+static const char *status_name(cell_status status)
+{
+	switch(status)
+	{
+	case MEETS:
+		return "meets";
+	case MISSES:
+		return "misses";
+	case PRUNED_MEETS:
+		return "pruned_meets";
+	case PRUNED_MISSES:
+		return "pruned_misses";
+	default:
+		return "unknown";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<int> tellers;
+	std::vector<range> gaps;
+	std::vector<range> services;
+	double target = DEFAULT_TARGET_P95_SECONDS;
+	replication_params base;
+	int option;
+
+	parse_tellers("1:10", &tellers);
+	parse_ranges("1-4", &gaps);
+	parse_ranges("30-360", &services);
+	default_bank_params(&base.model);
+	base.max_replications = DEFAULT_CELL_REPLICATIONS;
+	base.threads = 0;
+	base.seed = 1;
+	base.target_relative_width = 0;
+
+	while((option = getopt(argc, argv, "n:g:e:p:r:j:s:a:t:")) != -1)
+	{
+		bool valid = true;
+		switch(option)
+		{
+		case 'n':
+			valid = parse_tellers(optarg, &tellers);
+			break;
+
+		case 'g':
+			valid = parse_ranges(optarg, &gaps);
+			break;
+
+		case 'e':
+			valid = parse_ranges(optarg, &services);
+			break;
+
+		case 'p':
+			target = strtod(optarg, NULL);
+			break;
+
+		case 'r':
+			base.max_replications = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'j':
+			base.threads = strtoul(optarg, NULL, 10);
+			break;
+
+		case 's':
+			base.seed = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'a':
+			valid = parse_distribution(optarg, &base.model.arrival_distribution);
+			break;
+
+		case 't':
+			valid = parse_distribution(optarg, &base.model.service_distribution);
+			break;
+
+		default:
+			valid = false;
+			break;
+		}
+
+		if(!valid)
+		{
+			std::cerr << "usage: " << argv[0] << " [-n tellers] [-g gaps] [-e times] [-p seconds] [-r replications] [-j threads] [-s seed] [-a dist] [-t dist]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<load> loads;
+	for(unsigned int i=0;i<gaps.size();i++)
+	{
+		for(unsigned int j=0;j<services.size();j++)
+		{
+			load current;
+			current.gap = gaps[i];
+			current.service = services[j];
+			current.minimum = tellers.size();
+			current.solved = false;
+			cell empty_cell = {UNKNOWN, 0, 0};
+			current.cells.assign(tellers.size(), empty_cell);
+			loads.push_back(current);
+		}
+	}
+
+	std::vector<load *> order;
+	for(unsigned int i=0;i<loads.size();i++)
+	{
+		order.push_back(&loads[i]);
+	}
+	std::stable_sort(order.begin(), order.end(), lighter);
+	for(unsigned int i=0;i<order.size();i++)
+	{
+		solve(order[i], loads, tellers, base, target);
+	}
+
+	unsigned int simulated = 0;
+	std::cout << "arrival_gap_minutes,transaction_seconds,tellers,status,p95_wait,average_wait" << std::endl;
+	for(unsigned int i=0;i<loads.size();i++)
+	{
+		for(unsigned int j=0;j<tellers.size();j++)
+		{
+			const cell &current = loads[i].cells[j];
+			std::cout << loads[i].gap.low << "-" << loads[i].gap.high << ","
+					<< loads[i].service.low << "-" << loads[i].service.high << ","
+					<< tellers[j] << "," << status_name(current.status) << ",";
+			if(MEETS == current.status || MISSES == current.status)
+			{
+				std::cout << current.p95_wait << "," << current.average_wait;
+				simulated++;
+			}
+			else
+			{
+				std::cout << ",";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	std::cout << std::endl << "arrival_gap_minutes,transaction_seconds,minimum_tellers" << std::endl;
+	for(unsigned int i=0;i<loads.size();i++)
+	{
+		std::cout << loads[i].gap.low << "-" << loads[i].gap.high << ","
+				<< loads[i].service.low << "-" << loads[i].service.high << ",";
+		if(loads[i].minimum < (int)tellers.size())
+		{
+			std::cout << tellers[loads[i].minimum];
+		}
+		else
+		{
+			std::cout << "none";
+		}
+		std::cout << std::endl;
+	}
+
+	std::cerr << "simulated " << simulated << " of " << loads.size() * tellers.size() << " cells" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include <math.h>
+#include <string.h>
+
+#include "stats.h"
+
+// bucket 0 holds values below 1, after that every power of two is split
+// into STATS_BUCKETS_PER_OCTAVE equal parts
+static int bucket_for(double value)
+{
+	if(value < 1)
+	{
+		return 0;
+	}
+
+	int exponent;
+	double mantissa = frexp(value, &exponent);	// value = mantissa * 2^exponent, mantissa in [0.5, 1)
+	int bucket = 1 + (exponent - 1) * STATS_BUCKETS_PER_OCTAVE + (int)((mantissa - 0.5) * 2 * STATS_BUCKETS_PER_OCTAVE);
+	if(bucket >= STATS_BUCKETS)
+	{
+		bucket = STATS_BUCKETS - 1;
+	}
+	return bucket;
+}
+
+// middle of the range of values a bucket holds, values below 1 are
+// reported as 0 since times are whole seconds
+static double bucket_middle(int bucket)
+{
+	if(0 == bucket)
+	{
+		return 0;
+	}
+
+	int octave = (bucket - 1) / STATS_BUCKETS_PER_OCTAVE;
+	int step = (bucket - 1) % STATS_BUCKETS_PER_OCTAVE;
+	double low = ldexp(1.0 + (double)step / STATS_BUCKETS_PER_OCTAVE, octave);
+	double high = ldexp(1.0 + (double)(step + 1) / STATS_BUCKETS_PER_OCTAVE, octave);
+	return (low + high) / 2;
+}
+
+void stats_init(stats_accumulator *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+
+void stats_add(stats_accumulator *stats, double value)
+{
+	if(0 == stats->count || value < stats->min)
+	{
+		stats->min = value;
+	}
+	if(0 == stats->count || value > stats->max)
+	{
+		stats->max = value;
+	}
+
+	stats->count++;
+	double delta = value - stats->mean;
+	stats->mean += delta / stats->count;
+	stats->m2 += delta * (value - stats->mean);
+
+	stats->buckets[bucket_for(value)]++;
+}
+
+// adds everything seen by other into stats
+void stats_merge(stats_accumulator *stats, const stats_accumulator *other)
+{
+	if(0 == other->count)
+	{
+		return;
+	}
+	if(0 == stats->count)
+	{
+		*stats = *other;
+		return;
+	}
+
+	unsigned long count = stats->count + other->count;
+	double delta = other->mean - stats->mean;
+	stats->mean += delta * other->count / count;
+	stats->m2 += other->m2 + delta * delta * ((double)stats->count * other->count / count);
+	stats->count = count;
+
+	if(other->min < stats->min)
+	{
+		stats->min = other->min;
+	}
+	if(other->max > stats->max)
+	{
+		stats->max = other->max;
+	}
+
+	for(int i=0;i<STATS_BUCKETS;i++)
+	{
+		stats->buckets[i] += other->buckets[i];
+	}
+}
+
+// sample variance
+double stats_variance(const stats_accumulator *stats)
+{
+	if(stats->count < 2)
+	{
+		return 0;
+	}
+	return stats->m2 / (stats->count - 1);
+}
+
+// approximate value below which the given fraction (0 to 1) of values lie
+double stats_quantile(const stats_accumulator *stats, double quantile)
+{
+	if(0 == stats->count)
+	{
+		return 0;
+	}
+
+	unsigned long rank = (unsigned long)ceil(quantile * stats->count);
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	unsigned long seen = 0;
+	for(int i=0;i<STATS_BUCKETS;i++)
+	{
+		seen += stats->buckets[i];
+		if(seen >= rank)
+		{
+			double value = bucket_middle(i);
+			if(value < stats->min)
+			{
+				value = stats->min;
+			}
+			if(value > stats->max)
+			{
+				value = stats->max;
+			}
+			return value;
+		}
+	}
+	return stats->max;
+}
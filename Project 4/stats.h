@@ -0,0 +1,33 @@
+#ifndef _stats_
+#define _stats_
+
+// Streaming statistics, constant memory no matter how many values are added.
+//
+// Mean and variance use Welford's update so no sum of squares is kept, and
+// two accumulators can be merged (Chan et al.) which lets every teller keep
+// its own and combine them when the threads are joined.
+//
+// Quantiles come from a small histogram with 4 buckets per power of two,
+// good to about 10% of the value and mergeable by adding the buckets.
+
+#define STATS_BUCKETS_PER_OCTAVE 4
+#define STATS_OCTAVES 40
+#define STATS_BUCKETS (STATS_BUCKETS_PER_OCTAVE * STATS_OCTAVES + 1)
+
+typedef struct
+{
+	unsigned long count;
+	double mean;
+	double m2;			// sum of squared differences from the mean
+	double min;
+	double max;
+	unsigned long buckets[STATS_BUCKETS];
+} stats_accumulator;
+
+void stats_init(stats_accumulator *stats);
+void stats_add(stats_accumulator *stats, double value);
+void stats_merge(stats_accumulator *stats, const stats_accumulator *other);
+double stats_variance(const stats_accumulator *stats);
+double stats_quantile(const stats_accumulator *stats, double quantile);
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef _steal_queue_
+#define _steal_queue_
+
+#include <atomic>
+#include <sched.h>
+#include <stddef.h>
+
+#include "mpmc_queue.h"
+
+// One teller's own line when every teller has a line (see queue_bench.cc).
+//
+// The customer generator adds at the back, the owning teller takes from
+// the front and an idle teller steals from the back. Each line has its own
+// small spin lock, so threads only meet when the generator and a teller
+// touch the same line at once, instead of all of them going through one
+// shared queue. The length is kept outside the lock so the generator can
+// compare lines without locking any of them. CAPACITY must be a power of
+// two.
+
+template <typename T, size_t CAPACITY>
+class steal_queue
+{
+public:
+	steal_queue() : head(0), tail(0)
+	{
+		static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+		locked.clear();
+		length.store(0, std::memory_order_relaxed);
+		max_length = 0;
+		collisions.store(0, std::memory_order_relaxed);
+	}
+
+	// adds at the back, returns false if the line is full
+	bool push(const T &data)
+	{
+		lock();
+		if(tail - head == CAPACITY)
+		{
+			unlock();
+			return false;
+		}
+		buffer[tail & (CAPACITY - 1)] = data;
+		tail++;
+		if(max_length < (long)(tail - head))
+		{
+			max_length = tail - head;
+		}
+		length.store(tail - head, std::memory_order_relaxed);
+		unlock();
+		return true;
+	}
+
+	// owner takes from the front, returns false if the line is empty
+	bool pop(T &data)
+	{
+		lock();
+		if(tail == head)
+		{
+			unlock();
+			return false;
+		}
+		data = buffer[head & (CAPACITY - 1)];
+		head++;
+		length.store(tail - head, std::memory_order_relaxed);
+		unlock();
+		return true;
+	}
+
+	// another teller takes from the back, returns false if the line is empty
+	bool steal(T &data)
+	{
+		lock();
+		if(tail == head)
+		{
+			unlock();
+			return false;
+		}
+		tail--;
+		data = buffer[tail & (CAPACITY - 1)];
+		length.store(tail - head, std::memory_order_relaxed);
+		unlock();
+		return true;
+	}
+
+	// number of customers, only a snapshot while other threads are running
+	long size() const
+	{
+		return length.load(std::memory_order_relaxed);
+	}
+
+	long max_size() const
+	{
+		return max_length;
+	}
+
+	// times a thread found the line locked by another one
+	unsigned long contended() const
+	{
+		return collisions.load(std::memory_order_relaxed);
+	}
+
+private:
+	void lock()
+	{
+		if(!locked.test_and_set(std::memory_order_acquire))
+		{
+			return;
+		}
+		collisions.fetch_add(1, std::memory_order_relaxed);
+		while(locked.test_and_set(std::memory_order_acquire))
+		{
+			sched_yield();
+		}
+	}
+
+	void unlock()
+	{
+		locked.clear(std::memory_order_release);
+	}
+
+	alignas(CACHE_LINE_SIZE) std::atomic_flag locked;
+	size_t head;
+	size_t tail;
+	long max_length;
+	std::atomic<long> length;
+	std::atomic<unsigned long> collisions;
+	T buffer[CAPACITY];
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "trace.h"
+
+static const char *type_names[TRACE_TYPES] =
+{
+	"arrive", "dequeue", "service_start", "service_end", "break_start", "break_end", "idle"
+};
+
+static size_t mapped_size()
+{
+	return sizeof(trace_header) + (size_t)TRACE_FILE_EVENTS * sizeof(trace_event);
+}
+
+// creates the trace file and maps it, returns false if that failed
+bool trace_open(trace_file *file, const char *path)
+{
+	file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(file->fd < 0)
+	{
+		return false;
+	}
+
+	void *mapping = MAP_FAILED;
+	if(0 == ftruncate(file->fd, mapped_size()))
+	{
+		mapping = mmap(NULL, mapped_size(), PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+	}
+	if(MAP_FAILED == mapping)
+	{
+		close(file->fd);
+		return false;
+	}
+
+	file->header = (trace_header *)mapping;
+	file->events = (trace_event *)(file->header + 1);
+	file->next.store(0);
+	file->dropped.store(0);
+	return true;
+}
+
+// writes the header, cuts the file to the events written and unmaps it,
+// every buffer must have been flushed
+void trace_close(trace_file *file)
+{
+	uint64_t events = file->next.load();
+	if(events > TRACE_FILE_EVENTS)
+	{
+		events = TRACE_FILE_EVENTS;
+	}
+
+	memcpy(file->header->magic, TRACE_MAGIC, sizeof(file->header->magic));
+	file->header->version = TRACE_VERSION;
+	file->header->event_size = sizeof(trace_event);
+	file->header->ticks_per_second = TICKS_PER_SECOND;
+	file->header->events = events;
+	file->header->dropped = file->dropped.load();
+	memset(file->header->reserved, 0, sizeof(file->header->reserved));
+
+	munmap(file->header, mapped_size());
+	if(0 != ftruncate(file->fd, sizeof(trace_header) + events * sizeof(trace_event)))
+	{
+		// still readable, the header says how much of the sparse tail is used
+		perror("cannot trim the trace file");
+	}
+	close(file->fd);
+}
+
+void trace_buffer_init(trace_buffer *buffer, trace_file *file)
+{
+	buffer->file = file;
+	buffer->count = 0;
+}
+
+// copies the buffered events into the file
+void trace_flush(trace_buffer *buffer)
+{
+	if(NULL == buffer->file || 0 == buffer->count)
+	{
+		return;
+	}
+
+	trace_file *file = buffer->file;
+	uint64_t first = file->next.fetch_add(buffer->count, std::memory_order_relaxed);
+	uint64_t fits = 0;
+	if(first < TRACE_FILE_EVENTS)
+	{
+		fits = TRACE_FILE_EVENTS - first < buffer->count ? TRACE_FILE_EVENTS - first : buffer->count;
+		memcpy(&file->events[first], buffer->events, fits * sizeof(trace_event));
+	}
+	if(fits < buffer->count)
+	{
+		file->dropped.fetch_add(buffer->count - fits, std::memory_order_relaxed);
+	}
+	buffer->count = 0;
+}
+
+const char *trace_type_name(int type)
+{
+	return type >= 0 && type < TRACE_TYPES ? type_names[type] : "unknown";
+}
@@ -0,0 +1,114 @@
+#ifndef _trace_
+#define _trace_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "sim_time.h"
+
+// Binary event trace, instead of std::cout lines in the teller loop.
+//
+// Every thread writes fixed size events into its own buffer, without any
+// lock or atomic, and when the buffer is full it copies it in one piece
+// into a memory mapped trace file at a place it reserved with a single
+// atomic add. Recording an event is a few stores, so tracing can stay on;
+// with tracing off (no file) it is one compare. trace_decode.cc prints a
+// trace file.
+//
+// File layout: a trace_header, then header.events trace_events in the
+// order the buffers were flushed (sorted by time within one thread).
+
+// events a thread collects before copying them into the file
+#define TRACE_BUFFER_EVENTS 4096
+
+// the file is created sparse with room for this many events, events
+// past it are counted as dropped
+#define TRACE_FILE_EVENTS (1 << 24)
+
+#define TRACE_MAGIC "BANKTRCE"
+#define TRACE_VERSION 1
+
+// teller of events that do not belong to one (arrivals)
+#define TRACE_NO_TELLER 0xFFFF
+
+typedef enum
+{
+	TRACE_ARRIVE = 0,		// argument: customer number of the day
+	TRACE_DEQUEUE,			// argument: time the customer waited, ms
+	TRACE_SERVICE_START,	// argument: transaction time, ms
+	TRACE_SERVICE_END,
+	TRACE_BREAK_START,		// argument: break length, ms
+	TRACE_BREAK_END,
+	TRACE_IDLE				// teller is free again and looks for a customer
+} trace_type;
+
+#define TRACE_TYPES 7
+
+typedef struct
+{
+	sim_ticks time;
+	uint32_t argument;
+	uint16_t teller;
+	uint16_t type;
+} trace_event;
+
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t event_size;
+	int64_t ticks_per_second;
+	uint64_t events;
+	uint64_t dropped;
+	uint64_t reserved[3];		// pads the header to 64 bytes
+} trace_header;
+
+typedef struct
+{
+	int fd;
+	trace_header *header;
+	trace_event *events;
+	std::atomic<uint64_t> next;		// next free event in the file
+	std::atomic<uint64_t> dropped;
+} trace_file;
+
+// one per thread, file is NULL when tracing is off
+typedef struct
+{
+	trace_file *file;
+	uint32_t count;
+	trace_event events[TRACE_BUFFER_EVENTS];
+} trace_buffer;
+
+bool trace_open(trace_file *file, const char *path);
+void trace_close(trace_file *file);
+void trace_buffer_init(trace_buffer *buffer, trace_file *file);
+void trace_flush(trace_buffer *buffer);
+const char *trace_type_name(int type);
+
+// milliseconds for an event argument
+inline uint32_t trace_ms(sim_ticks ticks)
+{
+	return (uint32_t)(ticks / (TICKS_PER_SECOND / 1000));
+}
+
+inline void trace_record(trace_buffer *buffer, trace_type type, int teller, sim_ticks time, uint32_t argument)
+{
+	if(NULL == buffer->file)
+	{
+		return;
+	}
+
+	trace_event *event = &buffer->events[buffer->count++];
+	event->time = time;
+	event->argument = argument;
+	event->teller = teller < 0 ? TRACE_NO_TELLER : (uint16_t)teller;
+	event->type = (uint16_t)type;
+
+	if(TRACE_BUFFER_EVENTS == buffer->count)
+	{
+		trace_flush(buffer);
+	}
+}
+
+#endif
@@ -0,0 +1,80 @@
+// Prints a binary trace file written with -T as CSV, one event per line:
+// simulated time in seconds, teller (empty for arrivals), event and its
+// argument. Events are printed in time order.
+//
+// usage: trace_decode file
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+static bool earlier(const trace_event &event1, const trace_event &event2)
+{
+	return event1.time < event2.time;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc != 2)
+	{
+		std::cerr << "usage: " << argv[0] << " file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int fd = open(argv[1], O_RDONLY);
+	struct stat file_status;
+	if(fd < 0 || 0 != fstat(fd, &file_status) || (size_t)file_status.st_size < sizeof(trace_header))
+	{
+		std::cerr << "cannot read " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	void *mapping = mmap(NULL, file_status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(MAP_FAILED == mapping)
+	{
+		std::cerr << "cannot map " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const trace_header *header = (const trace_header *)mapping;
+	if(0 != memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) || TRACE_VERSION != header->version
+		|| sizeof(trace_event) != header->event_size
+		|| sizeof(trace_header) + header->events * sizeof(trace_event) > (size_t)file_status.st_size)
+	{
+		std::cerr << argv[1] << " is not a complete trace file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// every thread's events are in order, threads flushed at different times
+	const trace_event *first = (const trace_event *)(header + 1);
+	std::vector<trace_event> events(first, first + header->events);
+	std::stable_sort(events.begin(), events.end(), earlier);
+
+	std::cout << "time,teller,event,argument" << std::endl;
+	for(size_t i=0;i<events.size();i++)
+	{
+		std::cout << (double)events[i].time / header->ticks_per_second << ",";
+		if(TRACE_NO_TELLER != events[i].teller)
+		{
+			std::cout << events[i].teller;
+		}
+		std::cout << "," << trace_type_name(events[i].type) << "," << events[i].argument << std::endl;
+	}
+
+	if(header->dropped > 0)
+	{
+		std::cerr << header->dropped << " events did not fit in the trace file" << std::endl;
+	}
+
+	munmap(mapping, file_status.st_size);
+	close(fd);
+	return EXIT_SUCCESS;
+}